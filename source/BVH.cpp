@@ -0,0 +1,118 @@
+#include "BVH.h"
+
+#include <algorithm>
+
+void BVH::build(const std::vector<Box> & primitiveBoxes)
+{
+    nodes.clear();
+    order.clear();
+    if (primitiveBoxes.empty()) return;
+
+    std::vector<Vector3> centers(primitiveBoxes.size());
+    order.resize(primitiveBoxes.size());
+    for (size_t i = 0; i < primitiveBoxes.size(); i++){
+        centers[i] = primitiveBoxes[i].center();
+        order[i] = int(i);
+    }
+
+    nodes.reserve(primitiveBoxes.size() * 2);
+    nodes.push_back(Node());
+    buildNode(0, primitiveBoxes, centers, 0, int(order.size()));
+}
+
+void BVH::buildNode(int index, const std::vector<Box> & boxes, const std::vector<Vector3> & centers, int begin, int end)
+{
+    Box box, centerBox;
+    for (int i = begin; i < end; i++){
+        box.extend(boxes[order[i]]);
+        centerBox.extend(centers[order[i]]);
+    }
+    nodes[index].box = box;
+
+    const int leafSize = 4;
+    if (end - begin <= leafSize || centerBox.sizes().maxCoeff() == 0){
+        nodes[index].first = begin;
+        nodes[index].count = end - begin;
+        return;
+    }
+
+    // Median split on the longest axis of the centers
+    int axis;
+    centerBox.sizes().maxCoeff(&axis);
+    int mid = (begin + end) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&](int a, int b){
+        return centers[a][axis] < centers[b][axis];
+    });
+
+    // Siblings are stored next to each other
+    int children = int(nodes.size());
+    nodes[index].first = children;
+    nodes[index].count = 0;
+    nodes.push_back(Node());
+    nodes.push_back(Node());
+
+    buildNode(children, boxes, centers, begin, mid);
+    buildNode(children + 1, boxes, centers, mid, end);
+}
+
+void BVH::refit(const std::vector<Box> & primitiveBoxes)
+{
+    if (nodes.empty()) return;
+    refitNode(0, primitiveBoxes);
+}
+
+BVH::Box BVH::refitNode(int index, const std::vector<Box> & boxes)
+{
+    Box box;
+
+    if (nodes[index].count > 0){
+        for (int i = nodes[index].first; i < nodes[index].first + nodes[index].count; i++)
+            box.extend(boxes[order[i]]);
+    }
+    else{
+        int children = nodes[index].first;
+        box.extend(refitNode(children, boxes));
+        box.extend(refitNode(children + 1, boxes));
+    }
+
+    nodes[index].box = box;
+    return box;
+}
+
+void MeshBVH::build(const std::vector<Vector3> & points, const std::vector<Eigen::Vector3i> & triangles)
+{
+    this->points = points;
+    this->triangles = triangles;
+    tree.build(triangleBoxes());
+}
+
+void MeshBVH::refit(const std::vector<Vector3> & points)
+{
+    this->points = points;
+    tree.refit(triangleBoxes());
+}
+
+std::vector<BVH::Box> MeshBVH::triangleBoxes() const
+{
+    std::vector<BVH::Box> boxes(triangles.size());
+    for (size_t i = 0; i < triangles.size(); i++){
+        auto & t = triangles[i];
+        boxes[i].extend(points[t[0]]);
+        boxes[i].extend(points[t[1]]);
+        boxes[i].extend(points[t[2]]);
+    }
+    return boxes;
+}
+
+bool MeshBVH::raycast(const Vector3 & origin, const Vector3 & direction, double & tMax, int & triangle) const
+{
+    return tree.raycast(origin, direction, tMax, [&](int i, double & tClosest){
+        auto & tri = triangles[i];
+        double t;
+        if (!BVH::intersectTriangle(points[tri[0]], points[tri[1]], points[tri[2]], origin, direction, t)) return false;
+        if (t >= tClosest) return false;
+        tClosest = t;
+        triangle = i;
+        return true;
+    });
+}
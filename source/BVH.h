@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vector>
+#include <Eigen/Geometry>
+
+// Bounding volume hierarchy over axis aligned boxes, used for ray picking.
+// Primitives are referred to by index, the caller tests them in the raycast callback.
+class BVH
+{
+public:
+    typedef Eigen::Vector3d Vector3;
+    typedef Eigen::AlignedBox3d Box;
+
+    void build(const std::vector<Box> & primitiveBoxes);
+
+    // Same primitives with new boxes, keeps the tree topology
+    void refit(const std::vector<Box> & primitiveBoxes);
+
+    bool isEmpty() const { return nodes.empty(); }
+    Box bounds() const { return nodes.empty() ? Box() : nodes.front().box; }
+
+    // Closest hit along the ray, 'hit(i, tMax)' tests primitive i and lowers tMax when it is closer
+    template<class HitFunction>
+    bool raycast(const Vector3 & origin, const Vector3 & direction, double & tMax, HitFunction hit) const
+    {
+        if (nodes.empty()) return false;
+
+        Vector3 invDir(1.0 / direction[0], 1.0 / direction[1], 1.0 / direction[2]);
+
+        bool isHit = false;
+        int stack[64], stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while (stackSize)
+        {
+            const Node & node = nodes[stack[--stackSize]];
+
+            double tEnter;
+            if (!intersectBox(node.box, origin, invDir, tMax, tEnter)) continue;
+
+            if (node.count > 0){
+                for (int i = node.first; i < node.first + node.count; i++)
+                    if (hit(order[i], tMax)) isHit = true;
+                continue;
+            }
+
+            // Visit the nearer child first so the farther one is more likely pruned
+            int a = node.first, b = node.first + 1;
+            double ta, tb;
+            bool hitA = intersectBox(nodes[a].box, origin, invDir, tMax, ta);
+            bool hitB = intersectBox(nodes[b].box, origin, invDir, tMax, tb);
+            if (hitA && hitB){
+                if (ta < tb) std::swap(a, b);
+                stack[stackSize++] = a;
+                stack[stackSize++] = b;
+            }
+            else if (hitA) stack[stackSize++] = a;
+            else if (hitB) stack[stackSize++] = b;
+        }
+
+        return isHit;
+    }
+
+    // Moller-Trumbore, hits in front of the origin only
+    static bool intersectTriangle(const Vector3 & a, const Vector3 & b, const Vector3 & c,
+                                  const Vector3 & origin, const Vector3 & direction, double & t)
+    {
+        Vector3 edge1 = b - a, edge2 = c - a;
+        Vector3 pvec = direction.cross(edge2);
+        double det = edge1.dot(pvec);
+        if (det == 0) return false;
+        double invDet = 1.0 / det;
+        Vector3 tvec = origin - a;
+        double u = tvec.dot(pvec) * invDet;
+        if (u < 0 || u > 1) return false;
+        Vector3 qvec = tvec.cross(edge1);
+        double v = direction.dot(qvec) * invDet;
+        if (v < 0 || u + v > 1) return false;
+        t = edge2.dot(qvec) * invDet;
+        return t >= 0;
+    }
+
+protected:
+    // Leaves have count > 0 and own order[first, first+count), inner nodes have children first and first+1
+    struct Node{
+        Box box;
+        int first, count;
+    };
+    std::vector<Node> nodes;
+    std::vector<int> order;
+
+    void buildNode(int index, const std::vector<Box> & boxes, const std::vector<Vector3> & centers, int begin, int end);
+    Box refitNode(int index, const std::vector<Box> & boxes);
+
+    static bool intersectBox(const Box & box, const Vector3 & origin, const Vector3 & invDir, double tMax, double & tEnter)
+    {
+        double t0 = 0, t1 = tMax;
+        for (int i = 0; i < 3; i++){
+            double tNear = (box.min()[i] - origin[i]) * invDir[i];
+            double tFar = (box.max()[i] - origin[i]) * invDir[i];
+            if (tNear > tFar) std::swap(tNear, tFar);
+            t0 = tNear > t0 ? tNear : t0;
+            t1 = tFar < t1 ? tFar : t1;
+            if (t0 > t1) return false;
+        }
+        tEnter = t0;
+        return true;
+    }
+};
+
+// Triangle mesh with its hierarchy, refit when vertices move
+class MeshBVH
+{
+public:
+    typedef BVH::Vector3 Vector3;
+
+    void build(const std::vector<Vector3> & points, const std::vector<Eigen::Vector3i> & triangles);
+    void refit(const std::vector<Vector3> & points);
+
+    bool raycast(const Vector3 & origin, const Vector3 & direction, double & tMax, int & triangle) const;
+
+    BVH::Box bounds() const { return tree.bounds(); }
+    int numTriangles() const { return int(triangles.size()); }
+
+protected:
+    BVH tree;
+    std::vector<Vector3> points;
+    std::vector<Eigen::Vector3i> triangles;
+
+    std::vector<BVH::Box> triangleBoxes() const;
+};
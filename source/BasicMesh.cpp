@@ -0,0 +1,55 @@
+#include "BasicMesh.h"
+#include "SurfaceMeshModel.h"
+
+#include <QCoreApplication>
+#include <QThread>
+
+#include <vector>
+#include <type_traits>
+
+QBasicMesh toBasicMesh(opengp::SurfaceMesh::SurfaceMeshModel * m, QColor color)
+{
+    QBasicMesh mesh;
+    mesh.color = color;
+    if (m == nullptr) return mesh;
+
+    auto range = m->faces();
+    std::vector< std::decay<decltype(*range.begin())>::type > faces(range.begin(), range.end());
+    auto points = m->vertex_coordinates();
+
+    // Every face writes its own three slots of the pre-sized buffers
+    int numFaces = int(faces.size());
+    mesh.points.resize(numFaces * 3);
+    mesh.normals.resize(numFaces * 3);
+    QVector3D * fp = mesh.points.data();
+    QVector3D * fn = mesh.normals.data();
+
+    // Pool threads already convert shapes side by side, a team of their own would oversubscribe the cores
+    auto app = QCoreApplication::instance();
+    bool isMainThread = app != nullptr && QThread::currentThread() == app->thread();
+
+    #pragma omp parallel for schedule(static) if(isMainThread)
+    for (int i = 0; i < numFaces; i++)
+    {
+        // Newell's normal of the face, the plain face normal for triangles
+        QVector3D corners[3], normal, first, previous;
+        int corner = 0;
+        for (auto vf : m->vertices(faces[i])){
+            auto p = points[vf];
+            QVector3D v(p[0], p[1], p[2]);
+            if (corner < 3) corners[corner] = v;
+            if (corner == 0) first = v; else normal += QVector3D::crossProduct(previous, v);
+            previous = v;
+            corner++;
+        }
+        normal += QVector3D::crossProduct(previous, first);
+        normal.normalize();
+
+        for (int c = 0; c < 3; c++){
+            fp[i * 3 + c] = corners[c];
+            fn[i * 3 + c] = normal;
+        }
+    }
+
+    return mesh;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <QVector>
+#include <QVector3D>
+#include <QColor>
+
+namespace opengp{namespace SurfaceMesh{ class SurfaceMeshModel; }}
+
+// Flat colored triangle soup of one part, as drawn by thumbnails and exported by the command line tool
+struct QBasicMesh{
+    QVector<QVector3D> points, normals; QColor color;
+    void addTri(QVector3D v0, QVector3D v1, QVector3D v2,
+        QVector3D n0, QVector3D n1, QVector3D n2){
+        points << v0 << v1 << v2;
+        normals << n0 << n1 << n2;
+    }
+    bool isPoints;
+    QBasicMesh() : isPoints(false){}
+};
+
+// Flat shaded triangles of the first three corners of every face, the mesh itself is left untouched
+QBasicMesh toBasicMesh(opengp::SurfaceMesh::SurfaceMeshModel * m, QColor color);
@@ -0,0 +1,203 @@
+#include "CorrespondenceFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <QSaveFile>
+#include <QSet>
+#include <QHash>
+#include <QVector>
+
+static const char corrFileMagic[8] = {'T','B','C','O','R','R','\0','\0'};
+static const quint32 corrFileByteOrder = 0x01020304;
+static const quint32 corrFileVersion = 1;
+
+CorrespondenceFile::CorrespondenceFile() : data(nullptr), size(0), header(nullptr),
+    offsets(nullptr), strings(nullptr), corrRecords(nullptr), matchingRecords(nullptr)
+{
+
+}
+
+CorrespondenceFile::~CorrespondenceFile()
+{
+    close();
+}
+
+bool CorrespondenceFile::save(QString filename, const CorrMap & corr, const MatchingMap & matching)
+{
+    // Intern every name, sorted so that record order follows the order of QMap keys
+    QStringList names;
+    {
+        QSet<QString> all;
+        for (auto s : corr.keys()){
+            all << s;
+            for (auto p : corr[s].keys()){
+                all << p;
+                for (auto t : corr[s][p].keys()){
+                    all << t;
+                    for (auto q : corr[s][p][t]) all << q;
+                }
+            }
+        }
+        for (auto s : matching.keys()){
+            all << s;
+            for (auto t : matching[s].keys()) all << t;
+        }
+        names = all.toList();
+        std::sort(names.begin(), names.end());
+    }
+
+    QHash<QString, quint32> ids;
+    for (int i = 0; i < names.size(); i++) ids[names[i]] = i;
+
+    // String table
+    QVector<quint32> stringOffsets;
+    QByteArray stringData;
+    for (auto name : names){
+        stringOffsets << stringData.size();
+        stringData.append(name.toUtf8());
+    }
+    stringOffsets << stringData.size();
+
+    // Records, sorted by (s,p,t) while keeping the order of matches within a list
+    QVector<CorrRecord> corrs;
+    for (auto s : corr.keys())
+        for (auto p : corr[s].keys())
+            for (auto t : corr[s][p].keys())
+                for (auto q : corr[s][p][t])
+                    corrs << CorrRecord{ ids[s], ids[p], ids[t], ids[q] };
+
+    QVector<MatchingRecord> matchings;
+    for (auto s : matching.keys())
+        for (auto t : matching[s].keys())
+            if (matching[s][t].contains("min_cost"))
+                matchings << MatchingRecord{ ids[s], ids[t], matching[s][t]["min_cost"].toDouble() };
+
+    // Layout, every section starts 8 byte aligned
+    auto align = [](quint64 offset){ return (offset + 7) & ~quint64(7); };
+
+    Header h;
+    std::memset(&h, 0, sizeof(Header));
+    std::memcpy(h.magic, corrFileMagic, sizeof(h.magic));
+    h.byteOrder = corrFileByteOrder;
+    h.version = corrFileVersion;
+    h.numStrings = names.size();
+    h.numCorr = corrs.size();
+    h.numMatching = matchings.size();
+    h.stringOffsets = align(sizeof(Header));
+    h.stringData = align(h.stringOffsets + stringOffsets.size() * sizeof(quint32));
+    h.corrRecords = align(h.stringData + stringData.size());
+    h.matchingRecords = align(h.corrRecords + corrs.size() * sizeof(CorrRecord));
+
+    QByteArray buffer(h.matchingRecords + matchings.size() * sizeof(MatchingRecord), '\0');
+    std::memcpy(buffer.data(), &h, sizeof(Header));
+    std::memcpy(buffer.data() + h.stringOffsets, stringOffsets.constData(), stringOffsets.size() * sizeof(quint32));
+    std::memcpy(buffer.data() + h.stringData, stringData.constData(), stringData.size());
+    if (corrs.size()) std::memcpy(buffer.data() + h.corrRecords, corrs.constData(), corrs.size() * sizeof(CorrRecord));
+    if (matchings.size()) std::memcpy(buffer.data() + h.matchingRecords, matchings.constData(), matchings.size() * sizeof(MatchingRecord));
+
+    QSaveFile out(filename);
+    if (!out.open(QIODevice::WriteOnly)) return false;
+    out.write(buffer);
+    return out.commit();
+}
+
+bool CorrespondenceFile::open(QString filename)
+{
+    close();
+
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    size = file.size();
+    if (size < qint64(sizeof(Header))) { close(); return false; }
+
+    data = file.map(0, size);
+    if (data == nullptr) { close(); return false; }
+
+    auto h = reinterpret_cast<const Header*>(data);
+
+    // Sections lie after the header, aligned and inside the file. Sizes are compared with
+    // what is left after an offset so that corrupt counts can not overflow the sums
+    quint64 fileSize = quint64(size);
+    auto fits = [&](quint64 offset, quint64 count, quint64 itemSize){
+        return offset >= sizeof(Header) && offset % 8 == 0 && offset <= fileSize
+                && count <= (fileSize - offset) / itemSize;
+    };
+
+    // Validate before trusting any offset
+    bool isValid = std::memcmp(h->magic, corrFileMagic, sizeof(h->magic)) == 0
+            && h->byteOrder == corrFileByteOrder && h->version == corrFileVersion
+            && fits(h->stringOffsets, quint64(h->numStrings) + 1, sizeof(quint32))
+            && fits(h->stringData, 0, 1)
+            && fits(h->corrRecords, h->numCorr, sizeof(CorrRecord))
+            && fits(h->matchingRecords, h->numMatching, sizeof(MatchingRecord));
+    if (!isValid) { close(); return false; }
+
+    auto stringOffsets = reinterpret_cast<const quint32*>(data + h->stringOffsets);
+    auto corrs = reinterpret_cast<const CorrRecord*>(data + h->corrRecords);
+    auto matchings = reinterpret_cast<const MatchingRecord*>(data + h->matchingRecords);
+
+    // String offsets only grow and end inside the file
+    if (stringOffsets[0] != 0 || stringOffsets[h->numStrings] > fileSize - h->stringData) { close(); return false; }
+    for (quint32 i = 0; i < h->numStrings; i++)
+        if (stringOffsets[i] > stringOffsets[i + 1]) { close(); return false; }
+
+    // Records only refer to strings of the table
+    auto isString = [&](quint32 id){ return id < h->numStrings; };
+    for (quint32 i = 0; i < h->numCorr; i++){
+        auto & r = corrs[i];
+        if (!isString(r.s) || !isString(r.p) || !isString(r.t) || !isString(r.q)) { close(); return false; }
+    }
+    for (quint32 i = 0; i < h->numMatching; i++){
+        if (!isString(matchings[i].s) || !isString(matchings[i].t)) { close(); return false; }
+    }
+
+    header = h;
+    offsets = stringOffsets;
+    strings = reinterpret_cast<const char*>(data + h->stringData);
+    corrRecords = corrs;
+    matchingRecords = matchings;
+
+    return true;
+}
+
+void CorrespondenceFile::close()
+{
+    if (data) file.unmap(data);
+    if (file.isOpen()) file.close();
+
+    data = nullptr;
+    size = 0;
+    header = nullptr;
+    offsets = nullptr;
+    strings = nullptr;
+    corrRecords = nullptr;
+    matchingRecords = nullptr;
+}
+
+QString CorrespondenceFile::string(int id) const
+{
+    if (!header || id < 0 || id >= int(header->numStrings)) return QString();
+    return QString::fromUtf8(strings + offsets[id], offsets[id + 1] - offsets[id]);
+}
+
+bool CorrespondenceFile::read(CorrMap & corr, MatchingMap & matching) const
+{
+    if (!header) return false;
+
+    // Decode each name once
+    QVector<QString> names(header->numStrings);
+    for (int i = 0; i < int(header->numStrings); i++) names[i] = string(i);
+
+    for (quint32 i = 0; i < header->numCorr; i++){
+        auto & r = corrRecords[i];
+        corr[names[r.s]][names[r.p]][names[r.t]] << names[r.q];
+    }
+
+    for (quint32 i = 0; i < header->numMatching; i++){
+        auto & r = matchingRecords[i];
+        matching[names[r.s]][names[r.t]]["min_cost"] = r.cost;
+    }
+
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QFile>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+// Binary storage for dataset correspondences and pair-wise matching costs.
+// All shape and part names are interned into one sorted string table and records refer to them
+// by index, so loading decodes each name once from a memory mapped file instead of parsing
+// text line by line.
+class CorrespondenceFile
+{
+public:
+    typedef QMap< QString, QMap< QString, QMap<QString,QStringList> > > CorrMap;
+    typedef QMap< QString, QMap< QString, QVariantMap> > MatchingMap;
+
+    CorrespondenceFile();
+    ~CorrespondenceFile();
+
+    static bool save(QString filename, const CorrMap & corr, const MatchingMap & matching = MatchingMap());
+
+    bool open(QString filename);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    // Fill the in-memory structures in one pass over the records, false when no file is open.
+    // Every count, offset and string ID was checked against the file size when it was opened
+    bool read(CorrMap & corr, MatchingMap & matching) const;
+
+    struct Header{
+        char magic[8];
+        quint32 byteOrder, version;
+        quint32 numStrings, numCorr, numMatching, reserved;
+        quint64 stringOffsets, stringData, corrRecords, matchingRecords;
+    };
+    struct CorrRecord{ quint32 s, p, t, q; };
+    struct MatchingRecord{ quint32 s, t; double cost; };
+
+protected:
+    QString string(int id) const;
+
+    QFile file;
+    uchar * data;
+    qint64 size;
+
+    const Header * header;
+    const quint32 * offsets;
+    const char * strings;
+    const CorrRecord * corrRecords;
+    const MatchingRecord * matchingRecords;
+};
@@ -0,0 +1,133 @@
+#include "CorrespondenceIndex.h"
+
+CorrespondenceIndex::CorrespondenceIndex()
+{
+    clear();
+}
+
+void CorrespondenceIndex::clear()
+{
+    shapeNames.clear(); partNames.clear();
+    shapeIDs.clear(); partIDs.clear();
+    partSlots.clear(); entries.clear();
+    sourceShapes.clear();
+    slotTargets.clear(); targetShapes.clear();
+    targetMatches.clear(); matchParts.clear();
+
+    slotTargets << 0;
+    targetMatches << 0;
+}
+
+void CorrespondenceIndex::build(const CorrespondenceFile::CorrMap & corr)
+{
+    clear();
+
+    auto internShape = [&](const QString & name){
+        auto it = shapeIDs.find(name);
+        if (it != shapeIDs.end()) return it.value();
+        shapeNames << name;
+        return shapeIDs[name] = shapeNames.size() - 1;
+    };
+    auto internPart = [&](const QString & name){
+        auto it = partIDs.find(name);
+        if (it != partIDs.end()) return it.value();
+        partNames << name;
+        return partIDs[name] = partNames.size() - 1;
+    };
+
+    // QMap iteration keeps targets and matches in the same order as the nested maps
+    for (auto si = corr.constBegin(); si != corr.constEnd(); ++si)
+    {
+        int s = internShape(si.key());
+
+        for (auto pi = si.value().constBegin(); pi != si.value().constEnd(); ++pi)
+        {
+            int p = internPart(pi.key());
+
+            // Skip lists that are empty, these were only ever created by lookups
+            int numTargets = 0;
+
+            for (auto ti = pi.value().constBegin(); ti != pi.value().constEnd(); ++ti)
+            {
+                if (ti.value().isEmpty()) continue;
+
+                int t = internShape(ti.key());
+
+                entries[key(slotTargets.size() - 1, t)] = targetShapes.size();
+                targetShapes << t;
+
+                for (auto & q : ti.value()) matchParts << internPart(q);
+                targetMatches << matchParts.size();
+
+                numTargets++;
+            }
+
+            if (numTargets == 0) continue;
+
+            partSlots[key(s, p)] = slotTargets.size() - 1;
+            sourceShapes << s;
+            slotTargets << targetShapes.size();
+        }
+    }
+}
+
+CorrespondenceIndex::Range CorrespondenceIndex::matches(int s, int p, int t) const
+{
+    Range r = { nullptr, nullptr };
+    if (s < 0 || p < 0 || t < 0) return r;
+
+    auto slot = partSlots.find(key(s, p));
+    if (slot == partSlots.end()) return r;
+
+    auto entry = entries.find(key(slot.value(), t));
+    if (entry == entries.end()) return r;
+
+    int e = entry.value();
+    r.first = matchParts.constData() + targetMatches[e];
+    r.last = matchParts.constData() + targetMatches[e + 1];
+    return r;
+}
+
+int CorrespondenceIndex::slotOf(const QString & s, const QString & p) const
+{
+    int sid = shapeID(s), pid = partID(p);
+    if (sid < 0 || pid < 0) return -1;
+    return partSlots.value(key(sid, pid), -1);
+}
+
+bool CorrespondenceIndex::contains(const QString & s) const
+{
+    return sourceShapes.contains(shapeID(s));
+}
+
+bool CorrespondenceIndex::hasMatches(const QString & s, const QString & p, const QString & t) const
+{
+    return !matches(shapeID(s), partID(p), shapeID(t)).isEmpty();
+}
+
+QStringList CorrespondenceIndex::matches(const QString & s, const QString & p, const QString & t) const
+{
+    QStringList result;
+    for (auto q : matches(shapeID(s), partID(p), shapeID(t))) result << partNames[q];
+    return result;
+}
+
+QString CorrespondenceIndex::firstMatch(const QString & s, const QString & p, const QString & t) const
+{
+    auto r = matches(shapeID(s), partID(p), shapeID(t));
+    if (r.isEmpty()) return QString();
+    return partNames[*r.first];
+}
+
+QStringList CorrespondenceIndex::targets(const QString & s, const QString & p) const
+{
+    QStringList result;
+
+    int slot = slotOf(s, p);
+    if (slot < 0) return result;
+
+    for (int i = slotTargets[slot]; i < slotTargets[slot + 1]; i++)
+        result << shapeNames[targetShapes[i]];
+
+    return result;
+}
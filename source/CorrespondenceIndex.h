@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QString>
+#include <QStringList>
+
+#include "CorrespondenceFile.h"
+
+// Read-only correspondence lookups on interned integer IDs.
+// For every (shape, part) the target shapes and their matched parts are stored in flat arrays,
+// with an extra hash giving the match range of a (shape, part, target) in constant time.
+class CorrespondenceIndex
+{
+public:
+    CorrespondenceIndex();
+
+    void build(const CorrespondenceFile::CorrMap & corr);
+    void clear();
+    bool isEmpty() const { return matchParts.isEmpty(); }
+
+    // Interned IDs, -1 when unknown
+    int shapeID(const QString & name) const { return shapeIDs.value(name, -1); }
+    int partID(const QString & name) const { return partIDs.value(name, -1); }
+    const QString & shapeName(int id) const { return shapeNames[id]; }
+    const QString & partName(int id) const { return partNames[id]; }
+
+    // Matched part IDs of part 'p' of shape 's' inside shape 't'
+    struct Range{
+        const int * first, * last;
+        const int * begin() const { return first; }
+        const int * end() const { return last; }
+        int size() const { return int(last - first); }
+        bool isEmpty() const { return first == last; }
+    };
+    Range matches(int s, int p, int t) const;
+
+    // Adapter for name based callers
+    bool contains(const QString & s) const;
+    bool hasMatches(const QString & s, const QString & p, const QString & t) const;
+    QStringList matches(const QString & s, const QString & p, const QString & t) const;
+    QString firstMatch(const QString & s, const QString & p, const QString & t) const;
+    QStringList targets(const QString & s, const QString & p) const;
+
+protected:
+    QVector<QString> shapeNames, partNames;
+    QHash<QString, int> shapeIDs, partIDs;
+
+    // (shape, part) -> slot, slot -> [slotTargets[slot], slotTargets[slot+1]) in targetShapes
+    QHash<quint64, int> partSlots;
+    QSet<int> sourceShapes;
+    QVector<int> slotTargets, targetShapes;
+
+    // target entry -> [targetMatches[e], targetMatches[e+1]) in matchParts
+    QVector<int> targetMatches, matchParts;
+    QHash<quint64, int> entries;
+
+    static quint64 key(int a, int b) { return (quint64(quint32(a)) << 32) | quint32(b); }
+    int slotOf(const QString & s, const QString & p) const;
+};
@@ -3,19 +3,25 @@
 
 #include "Document.h"
 #include "Model.h"
-#include "Viewer.h"
 
-#include <QApplication>
-#include <QDesktopWidget>
-#include <QProgressDialog>
 #include <QTimer>
 #include <QThread>
+#include <QFileInfo>
+#include <QDirIterator>
+#include <QDateTime>
+#include <QSettings>
+#include <QtConcurrent>
 
 #include "DocumentAnalyzeWorker.h"
+#include "PairwiseCache.h"
+#include "ThumbnailCache.h"
 
-Document::Document(QObject *parent) : QObject(parent)
+Document::Document(QObject *parent) : QObject(parent), currentCorrIndex(new CorrespondenceIndex)
 {
+    setMaxLoading(QThread::idealThreadCount());
 
+    QSettings settings;
+    setCacheBudget(qint64(settings.value("modelCacheMB", 2048).toInt()) << 20);
 }
 
 bool Document::loadModel(QString filename)
@@ -58,29 +64,42 @@ bool Document::loadDataset(QString datasetFolder)
     // Store dataset path
     datasetPath = datasetFolder;
 
+    // Shape names of another dataset may be the same
+    {
+        QMutexLocker locker(&hashLock);
+        shapeHashes.clear();
+    }
+
     // Load shapes in dataset
     {
         QDir datasetDir(datasetPath);
         QStringList subdirs = datasetDir.entryList(QDir::Dirs | QDir::NoSymLinks | QDir::NoDotAndDotDot);
 
-        for(auto subdir : subdirs)
-        {
-            // Special folders
-            if (subdir == "corr") continue;
+        // Special folders
+        subdirs.removeAll("corr");
 
-            QDir d(datasetPath + "/" + subdir);
+        // Scan folders in parallel, directory listings dominate on large datasets
+        QString path = datasetPath;
+        auto entries = QtConcurrent::blockingMapped< QList<QVariantMap> >(subdirs, std::function<QVariantMap(const QString&)>([path](const QString & subdir){
+            QVariantMap entry;
 
-            // Check if no graph is in this folder
-            if (d.entryList(QStringList() << "*.xml", QDir::Files).isEmpty()) continue;
+            QDir d(path + "/" + subdir);
 
+            // Check if no graph is in this folder
             auto xml_files = d.entryList(QStringList() << "*.xml", QDir::Files);
+            if(xml_files.empty()) return entry;
 
-            if(xml_files.empty()) continue;
+            entry["Name"] = subdir;
+            entry["graphFile"] = d.absolutePath() + "/" + (xml_files.front());
+            entry["thumbFile"] = d.absolutePath() + "/" + d.entryList(QStringList() << "*.png", QDir::Files).join("");
+            entry["objFile"] = d.absolutePath() + "/" + d.entryList(QStringList() << "*.obj", QDir::Files).join("");
+            return entry;
+        }));
 
-            dataset[subdir]["Name"] = subdir;
-            dataset[subdir]["graphFile"] = d.absolutePath() + "/" + (xml_files.front());
-            dataset[subdir]["thumbFile"] = d.absolutePath() + "/" + d.entryList(QStringList() << "*.png", QDir::Files).join("");
-            dataset[subdir]["objFile"] = d.absolutePath() + "/" + d.entryList(QStringList() << "*.obj", QDir::Files).join("");
+        for(int i = 0; i < subdirs.size(); i++)
+        {
+            if(entries[i].isEmpty()) continue;
+            dataset[subdirs[i]] = entries[i];
         }
     }
 
@@ -147,76 +166,76 @@ QString Document::categoryOf(QString modelName)
     return result;
 }
 
-void Document::analyze(QString categoryName)
+// Sizes and modification times of the files a content hash covers, cheap to compare with an earlier hash
+static QString shapeStamp(QString graphFile)
 {
-    if(!categories.keys().contains(categoryName)) return;
-
-    // Create progress bar
-    auto bar = new QProgressDialog("Please wait...", QString(), 0, 100, 0);
-    bar->setWindowTitle("Processing");
-    bar->show();
-    QRect screenGeometry = QApplication::desktop()->screenGeometry();
-    int x = (screenGeometry.width()-bar->width()) / 2;
-    int y = (screenGeometry.height()-bar->height()) / 2;
-    bar->move(x, y);
-
-    auto worker = new DocumentAnalyzeWorker(this);
+    QStringList stamp;
+    auto add = [&](const QFileInfo & info){
+        stamp << QString("%1:%2:%3").arg(info.absoluteFilePath()).arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch());
+    };
 
-    QThread* thread = new QThread;
-    worker->moveToThread(thread);
-    connect(thread, SIGNAL (started()), worker, SLOT (processShapeDataset()));
-    connect(worker, SIGNAL (finished()), thread, SLOT (quit()));
-    connect(worker, SIGNAL (finished()), this, SLOT (sayCategoryAnalysisDone()));
-    connect(worker, SIGNAL (finished()), bar, SLOT (deleteLater()));
-    connect(worker, SIGNAL (finished()), worker, SLOT (deleteLater()));
-    connect(thread, SIGNAL (finished()), thread, SLOT (deleteLater()));
+    QFileInfo graphInfo(graphFile);
+    add(graphInfo);
 
-    // Connect progress bar to worker
-    bar->connect(worker, SIGNAL(progress(int)), SLOT(setValue(int)));
-    bar->connect(worker, SIGNAL(progressText(QString)), SLOT(setLabelText(QString)));
+    QDirIterator it(graphInfo.absolutePath(), QStringList() << "*.obj", QDir::Files, QDirIterator::Subdirectories);
+    while(it.hasNext()){
+        it.next();
+        add(it.fileInfo());
+    }
 
-    thread->start(QThread::HighestPriority);
+    stamp.sort();
+    return stamp.join("|");
 }
 
-void Document::computePairwise(QString categoryName)
+QString Document::shapeHash(QString modelName)
 {
-    if(!categories.keys().contains(categoryName)) return;
+    if(!dataset.contains(modelName)) return QString();
+
+    // A shape saved or edited since it was hashed is hashed again
+    QString graphFile = dataset[modelName]["graphFile"].toString();
+    QString stamp = shapeStamp(graphFile);
+    {
+        QMutexLocker locker(&hashLock);
+        if(shapeHashes.contains(modelName) && shapeHashes[modelName].first == stamp) return shapeHashes[modelName].second;
+    }
 
-    // Create progress bar
-    auto bar = new QProgressDialog("Please wait...", QString(), 0, 100, 0);
-    bar->setWindowTitle("Processing");
-    bar->show();
-    QRect screenGeometry = QApplication::desktop()->screenGeometry();
-    int x = (screenGeometry.width()-bar->width()) / 2;
-    int y = (screenGeometry.height()-bar->height()) / 2;
-    bar->move(x, y);
+    // Files are hashed without the lock, two threads may hash the same shape once each
+    QString hash = PairwiseCache::contentHash(graphFile);
 
-    auto worker = new DocumentAnalyzeWorker(this);
+    QMutexLocker locker(&hashLock);
+    shapeHashes[modelName] = qMakePair(stamp, hash);
+    return hash;
+}
 
-    QThread* thread = new QThread;
+QString Document::thumbnailFile(QString modelName, const QMatrix4x4 & camera, QSize size)
+{
+    return ThumbnailCache(datasetPath + "/thumbnails").entryFile(shapeHash(modelName), camera, size);
+}
 
-    worker->moveToThread(thread);
-    connect(thread, SIGNAL (started()), worker, SLOT (processAllPairWise()));
-    connect(worker, SIGNAL (finished()), thread, SLOT (quit()));
-    connect(worker, SIGNAL (finished()), this, SLOT (sayPairwiseAnalysisDone()));
-    connect(worker, SIGNAL (finished()), bar, SLOT (deleteLater()));
-    connect(worker, SIGNAL (finished()), worker, SLOT (deleteLater()));
-    connect(thread, SIGNAL (finished()), thread, SLOT (deleteLater()));
+QSharedPointer<const CorrespondenceIndex> Document::corrIndex() const
+{
+    QMutexLocker locker(&corrIndexLock);
+    return currentCorrIndex;
+}
 
-    // Connect progress bar to worker
-    bar->connect(worker, SIGNAL(progress(int)), SLOT(setValue(int)));
-    bar->connect(worker, SIGNAL(progressText(QString)), SLOT(setLabelText(QString)));
+void Document::indexCorrespondence()
+{
+    auto index = QSharedPointer<CorrespondenceIndex>(new CorrespondenceIndex);
+    index->build(datasetCorr);
 
-    thread->start(QThread::HighestPriority);
+    QMutexLocker locker(&corrIndexLock);
+    currentCorrIndex = index;
 }
 
 void Document::sayCategoryAnalysisDone()
 {
+    indexCorrespondence();
     emit(categoryAnalysisDone());
 }
 
 void Document::sayPairwiseAnalysisDone()
 {
+    indexCorrespondence();
     emit(categoryPairwiseDone());
 }
 
@@ -238,6 +257,7 @@ void Document::savePairwise(QString filename)
 	}
 
 	// Full dataset matches
+	CorrespondenceFile::CorrMap pairCorr;
 	{
 		QFile file(filename + ".match");
 		if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return;
@@ -254,19 +274,72 @@ void Document::savePairwise(QString filename)
 
 					datasetCorr[s][p.first][t] << p.second;
 					datasetCorr[t][p.second][s] << p.first;
+
+					pairCorr[s][p.first][t] << p.second;
+					pairCorr[t][p.second][s] << p.first;
 				}
 				out << s << " " << t << " " << matches.join("|") << "\n";
 			}
 		}
 	}
+
+	// Indexed binary copy, preferred when loading
+	CorrespondenceFile::save(filename + ".bin", pairCorr, datasetMatching);
+}
+
+// A binary copy is used unless one of its text sources was edited after it was written
+static bool isBinaryCurrent(QStringList textFiles, QString binFile)
+{
+	QFileInfo binInfo(binFile);
+	if (!binInfo.exists()) return false;
+	for (auto textFile : textFiles){
+		QFileInfo textInfo(textFile);
+		if (textInfo.exists() && textInfo.lastModified() > binInfo.lastModified()) return false;
+	}
+	return true;
 }
 
 void Document::loadPairwise(QString filename)
+{
+	CorrespondenceFile::CorrMap pairCorr;
+	CorrespondenceFile::MatchingMap pairMatching;
+
+	// Corrupt binary copies are rebuilt from the text files
+	CorrespondenceFile binFile;
+	if (isBinaryCurrent(QStringList() << filename << filename + ".match", filename + ".bin")
+		&& binFile.open(filename + ".bin") && binFile.read(pairCorr, pairMatching))
+	{
+		binFile.close();
+	}
+	else
+	{
+		if (!loadPairwiseText(filename, pairCorr, pairMatching)) return;
+
+		// Import once, later loads use the binary copy
+		CorrespondenceFile::save(filename + ".bin", pairCorr, pairMatching);
+	}
+
+	for (auto s : pairMatching.keys()){
+		for (auto t : pairMatching[s].keys()){
+			datasetMatching[s][t]["min_cost"] = pairMatching[s][t]["min_cost"];
+			datasetMatching[t][s]["min_cost"] = pairMatching[s][t]["min_cost"];
+		}
+	}
+
+	for (auto s : pairCorr.keys())
+		for (auto p : pairCorr[s].keys())
+			for (auto t : pairCorr[s][p].keys())
+				datasetCorr[s][p][t] << pairCorr[s][p][t];
+
+	loadClustering(filename + ".cluster");
+}
+
+bool Document::loadPairwiseText(QString filename, CorrespondenceFile::CorrMap & pairCorr, CorrespondenceFile::MatchingMap & pairMatching)
 {
 	// Pair-wise distances
 	{
 		QFile file(filename);
-		if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return;
+		if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
 
 		QTextStream in(&file);
 		auto lines = in.readAll().split(QRegExp("[\r\n]"), QString::SkipEmptyParts);
@@ -274,15 +347,14 @@ void Document::loadPairwise(QString filename)
 		for (auto line : lines){
 			auto item = line.split(QRegExp("[ \t]"), QString::SkipEmptyParts);
 			if (item.size() != 3) continue;
-			datasetMatching[item[0]][item[1]]["min_cost"] = item[2].toDouble();
-			datasetMatching[item[1]][item[0]]["min_cost"] = item[2].toDouble();
+			pairMatching[item[0]][item[1]]["min_cost"] = item[2].toDouble();
 		}
 	}
     
 	// Full dataset matches
 	{
 		QFile file(filename + ".match");
-		if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return;
+		if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
 
 		QTextStream in(&file);
 		auto lines = in.readAll().split(QRegExp("[\r\n]"), QString::SkipEmptyParts);
@@ -297,15 +369,20 @@ void Document::loadPairwise(QString filename)
 			{
 				auto p = txtPair.split(",", QString::SkipEmptyParts);
 
-				datasetCorr[s][p.front()][t] << p.back();
-				datasetCorr[t][p.back()][s] << p.front();
+				pairCorr[s][p.front()][t] << p.back();
+				pairCorr[t][p.back()][s] << p.front();
 			}
 		}
 	}
 
+	return true;
+}
+
+void Document::loadClustering(QString filename)
+{
     // Load clustering file if any
     {
-        QFile file(filename + ".cluster");
+        QFile file(filename);
         if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return;
 
         QTextStream in(&file);
@@ -366,30 +443,43 @@ void Document::saveDatasetCorr(QString filename)
             for (auto t : datasetCorr[s][p].keys())
                 for (auto q : datasetCorr[s][p][t])
                     out << s << " " << p << " " << t << " " << q << "\n";
+
+    file.close();
+
+    // Indexed binary copy, preferred when loading
+    CorrespondenceFile::save(filename + ".bin", datasetCorr);
 }
 
 void Document::loadDatasetCorr(QString filename)
 {
+    // Corrupt binary copies are rebuilt from the text file
+    CorrespondenceFile binFile;
+    if (isBinaryCurrent(QStringList() << filename, filename + ".bin") && binFile.open(filename + ".bin"))
+    {
+        CorrespondenceFile::MatchingMap unused;
+        if (binFile.read(datasetCorr, unused)) return;
+    }
+
     QFile file(filename);
 	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return;
 
 	QTextStream in(&file);
 	auto lines = in.readAll().split(QRegExp("[\r\n]"), QString::SkipEmptyParts);
 
+    CorrespondenceFile::CorrMap corr;
 	for (auto line : lines){
 		auto item = line.split(QRegExp("[ \t]"), QString::SkipEmptyParts);
         if (item.size() != 4) continue;
-        datasetCorr[item[0]][item[1]][item[2]].push_back(item[3]);
+        corr[item[0]][item[1]][item[2]].push_back(item[3]);
     }
-}
 
-void Document::drawModel(QString name, QWidget *widget)
-{
-    auto glwidget = (Viewer*)widget;
-    if (glwidget == nullptr) return;
+    // Import once, later loads use the binary copy
+    CorrespondenceFile::save(filename + ".bin", corr);
 
-    auto m = getModel(name);
-    if(m != nullptr) m->draw(glwidget);
+    for (auto s : corr.keys())
+        for (auto p : corr[s].keys())
+            for (auto t : corr[s][p].keys())
+                datasetCorr[s][p][t] << corr[s][p][t];
 }
 
 void Document::createCurveFromPoints(QString modelName, QVector<QVector3D> & points)
@@ -495,17 +585,105 @@ Model* Document::getModel(QString name)
 
 Model* Document::cacheModel(QString name)
 {
-    if(cachedModels.contains(name)){
-        return cachedModels[name].data();
-    }else{
-        if(!dataset.contains(name)) return nullptr;
-        QString filename = dataset[name]["graphFile"].toString();
+    // Joins a load already in flight instead of reading the files twice
+    return cacheModelAsync(name).result();
+}
+
+static QFuture<Model*> readyModelFuture(Model * model)
+{
+    QFutureInterface<Model*> result;
+    result.reportStarted();
+    result.reportResult(model);
+    result.reportFinished();
+    return result.future();
+}
+
+QFuture<Model*> Document::cacheModelAsync(QString name)
+{
+    QMutexLocker locker(&cacheLock);
+
+    auto cached = cachedModels.get(name);
+    if(cached) return readyModelFuture(cached.data());
+    if(loadingModels.contains(name)) return loadingModels[name];
+    if(!dataset.contains(name)) return readyModelFuture(nullptr);
+
+    QString filename = dataset[name]["graphFile"].toString();
+    QThread * documentThread = thread();
 
-        auto model = QSharedPointer<Model>(new Model());
-        if(!model->loadFromFile(filename)) return nullptr;
-        cachedModels[name] = model;
+    // The lock is held until the future is registered, so the task can not finish before that
+    auto future = QtConcurrent::run(&loaderPool, [=]() -> Model* {
+        // Evicted models are deleted from the event loop, so pointers handed out earlier stay valid until then
+        auto model = QSharedPointer<Model>(new Model(), &QObject::deleteLater);
+        bool isLoaded = model->loadFromFile(filename);
+
+        // Models live with the document, not with the loader thread
+        model->moveToThread(documentThread);
+
+        QMutexLocker locker(&cacheLock);
+        loadingModels.remove(name);
+        if(!isLoaded) return nullptr;
+        cachedModels.insert(name, model);
         return model.data();
-    }
+    });
+
+    loadingModels[name] = future;
+    return future;
+}
+
+QVector< QFuture<Model*> > Document::prefetchCategory(QString categoryName)
+{
+    QVector< QFuture<Model*> > futures;
+    for(auto name : categories[categoryName].toStringList())
+        futures << cacheModelAsync(name);
+    return futures;
+}
+
+void Document::setMaxLoading(int count)
+{
+    loaderPool.setMaxThreadCount(qMax(1, count));
+}
+
+void Document::pinModel(QString name)
+{
+    QMutexLocker locker(&cacheLock);
+    cachedModels.pin(name);
+}
+
+void Document::unpinModel(QString name)
+{
+    QMutexLocker locker(&cacheLock);
+    cachedModels.unpin(name);
+}
+
+Document::PinnedModels::PinnedModels(Document * document, QStringList names) : document(document), names(names)
+{
+    for(auto name : names) document->pinModel(name);
+}
+
+Document::PinnedModels::~PinnedModels()
+{
+    if(document.isNull()) return;
+    for(auto name : names) document->unpinModel(name);
+}
+
+void Document::setCacheBudget(qint64 bytes)
+{
+    QMutexLocker locker(&cacheLock);
+    cachedModels.setBudget(bytes);
+}
+
+QVariantMap Document::cacheStats()
+{
+    QMutexLocker locker(&cacheLock);
+
+    QVariantMap stats;
+    stats["hits"] = cachedModels.hits;
+    stats["misses"] = cachedModels.misses;
+    stats["evictions"] = cachedModels.evictions;
+    stats["count"] = cachedModels.count();
+    stats["usedBytes"] = cachedModels.usedBytes();
+    stats["budgetBytes"] = cachedModels.budget();
+    return stats;
 }
 
 Structure::ShapeGraph * Document::cloneAsShapeGraph(Model * m)
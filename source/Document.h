@@ -4,9 +4,20 @@
 #include <QVector>
 #include <QSharedPointer>
 #include <QVariantMap>
+#include <QFuture>
+#include <QMutex>
+#include <QPointer>
+#include <QStringList>
+#include <QThreadPool>
+#include <QMatrix4x4>
+
+#include "CorrespondenceFile.h"
+#include "CorrespondenceIndex.h"
+#include "ModelCache.h"
 
 namespace Structure{ struct ShapeGraph; }
 class Model;
+class QWidget;
 namespace opengp{ namespace SurfaceMesh{ class SurfaceMeshModel; } }
 
 class Document : public QObject
@@ -29,6 +40,10 @@ public:
     QString currentCategory;
     bool loadDataset(QString datasetFolder);
     QString categoryOf(QString modelName);
+    QString shapeHash(QString modelName); // thread-safe
+
+    // Where the thumbnail of a shape seen through 'camera' is cached, empty when it can not be
+    QString thumbnailFile(QString modelName, const QMatrix4x4 & camera, QSize size);
 
 	// Computed correspondence
     QMap< QString, QMap< QString, QMap<QString,QStringList> > > datasetCorr;
@@ -36,11 +51,21 @@ public:
 	void saveDatasetCorr(QString filename);
     void loadDatasetCorr(QString filename);
 
+    // Read-optimized lookups into datasetCorr, rebuilt when an analysis finishes. A rebuild publishes
+    // a new index, so workers take one snapshot per job and keep reading it while the next is built
+    QSharedPointer<const CorrespondenceIndex> corrIndex() const;
+    void indexCorrespondence();
+
     // Compute pair-wise model matchings
     QMap< QString, QMap< QString, QVariantMap> > datasetMatching;
     void computePairwise(QString categoryName);
+
+    // Landmark shapes of categories too large to match all pairs, only pairs with a landmark are matched
+    QMap<QString, QStringList> landmarks;
     void savePairwise(QString filename);
     void loadPairwise(QString filename);
+    bool loadPairwiseText(QString filename, CorrespondenceFile::CorrMap & pairCorr, CorrespondenceFile::MatchingMap & pairMatching);
+    void loadClustering(QString filename);
 
     // Visualization:
     void drawModel(QString modelName, QWidget * widget);
@@ -73,14 +98,45 @@ public:
     // Memory access of dataset
     Model * cacheModel(QString name);
 
+    // Background loading of dataset models, at most 'maxLoading' files are read at once
+    QFuture<Model*> cacheModelAsync(QString name);
+    QVector< QFuture<Model*> > prefetchCategory(QString categoryName);
+    void setMaxLoading(int count);
+
+    // Models in use are kept resident, the rest is evicted past the memory budget
+    void pinModel(QString name);
+    void unpinModel(QString name);
+
+    // Keeps models pinned while it lives, for tools that use cached models across events
+    class PinnedModels{
+    public:
+        PinnedModels(Document * document, QStringList names);
+        ~PinnedModels();
+    private:
+        QPointer<Document> document;
+        QStringList names;
+    };
+
+    void setCacheBudget(qint64 bytes);
+    QVariantMap cacheStats();
+
 	// Helper function
 	Structure::ShapeGraph * cloneAsShapeGraph(Model * m);
 
 protected:
     QVector< QSharedPointer<Model> > models;
-    QMap< QString, QSharedPointer<Model> > cachedModels;
+    ModelCache cachedModels;
+    QMap< QString, QFuture<Model*> > loadingModels;
+    QMutex cacheLock;
+    QMap< QString, QPair<QString,QString> > shapeHashes; // stamp and hash
+    QMutex hashLock;
+    QSharedPointer<const CorrespondenceIndex> currentCorrIndex;
+    mutable QMutex corrIndexLock;
     QVariantMap options;
 
+    // Declared last so pending loads finish before the cache goes away
+    QThreadPool loaderPool;
+
 signals:
     void analyzeProgress(int);
     void categoryAnalysisDone();
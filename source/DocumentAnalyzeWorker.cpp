@@ -2,9 +2,51 @@
 
 #include <iostream>
 #include <QThread>
+#include <QFile>
+#include <QAtomicInt>
+#include <QSettings>
+#include <QTextStream>
+#include <limits>
 
 #include "BatchProcess.h"
 #include "ShapeGraph.h"
+#include "Model.h"
+#include "PairwiseCache.h"
+
+// Pick the lowest cost job out of the reports of both search directions
+static QVariantMap bestReport(const QVector< QVector<QVariantMap> > & reports)
+{
+    double minEnergy = 1.0;
+    int totalTime = 0;
+    QVariantMap minJob;
+    for (auto & reportVec : reports){
+        for (auto & report : reportVec){
+            totalTime += report["search_time"].toInt();
+            double c = report["min_cost"].toDouble();
+            if (c < minEnergy){
+                minEnergy = c;
+                minJob = report;
+            }
+        }
+    }
+
+    auto firstReport = reports.front().front();
+    if (minJob["job_uid"].toInt() != firstReport["job_uid"].toInt()) minJob["isReversed"].setValue(true);
+
+    return minJob;
+}
+
+// Landmarks of an earlier run of the current category, if it was matched with landmarks
+static void loadLandmarks(Document * document)
+{
+    document->landmarks.remove(document->currentCategory);
+
+    QFile file(document->datasetPath + "/" + document->currentCategory + "_landmarks.txt");
+    if(!file.open(QFile::ReadOnly | QFile::Text)) return;
+
+    auto names = QTextStream(&file).readAll().split("\n", QString::SkipEmptyParts);
+    if(!names.isEmpty()) document->landmarks[document->currentCategory] = names;
+}
 
 void DocumentAnalyzeWorker::processAllPairWise()
 {
@@ -13,101 +55,201 @@ void DocumentAnalyzeWorker::processAllPairWise()
 
     // Get names of shapes of selected category into memory
     auto catModels = document->categories[ document->currentCategory ].toStringList();
+    Document::PinnedModels pinned(document, catModels);
 
     // Load all shapes into memory
+    QVector<Model*> cachedShapes;
+    QStringList shapeHashes;
+    auto loading = document->prefetchCategory(document->currentCategory);
     for(int i = 0; i < catModels.size(); i++){
-        document->cacheModel(catModels.at(i));
+        cachedShapes << loading[i].result();
+        shapeHashes << document->shapeHash(catModels.at(i));
         emit(progress(loadShapesPercent * (double(i) / (catModels.size()-1))));
     }
 
-    // Check for existing results
+    int k = 4; // search parameter
+
+    QVariantMap options;
+    options["roundtrip"].setValue(true);
+    options["k"].setValue( k );
+    options["isQuietMode"].setValue(true);
+    options["isManyTypesJobs"].setValue(true);
+    options["isAllowCutsJoins"].setValue(true);
+
+    // Per pair results from earlier, possibly interrupted, runs with the same options
+    PairwiseCache cache(document->datasetPath + "/corr/pairwise", options);
+
+    // Check for existing results from before the pair cache existed
     QString matching_file = document->datasetPath + "/" + document->currentCategory + "_matches.txt";
-    if(QFileInfo(matching_file).exists()){
+    if(QFileInfo(matching_file).exists() && !cache.exists()){
         document->loadPairwise(matching_file);
+        loadLandmarks(document);
         emit(progress(100));
         emit(finished());
         return;
     }
 
-    int k = 4; // search parameter
+    int numProcessed = 0, numToProcess = 0;
 
-    int numPairwise = ((catModels.size()-1) * catModels.size()) / 2.0;
-    int c = 0;
+    // Matches the given pairs in parallel and records them, returns the result of each pair
+    auto matchPairs = [&](const QVector< QPair<int,int> > & pairs){
 
-    for(int i = 0; i < catModels.size(); i++)
-    {
-        for(int j = i+1; j < catModels.size(); j++)
+        // Reuse results of pairs whose shapes did not change
+        QVector<QVariantMap> pairResults(pairs.size());
+        QVector<int> pendingPairs;
+        for(int p = 0; p < pairs.size(); p++)
         {
-            QString sourceName = catModels.at(i);
-            QString targetName = catModels.at(j);
+            auto sourceHash = shapeHashes.at(pairs[p].first);
+            auto targetHash = shapeHashes.at(pairs[p].second);
+
+            bool isCached = !sourceHash.isEmpty() && !targetHash.isEmpty() &&
+                    cache.load(sourceHash, targetHash, pairResults[p]);
 
-            emit(progressText(QString("Processing: %1-%2").arg(sourceName).arg(targetName)));
+            if(!isCached) pendingPairs << p;
+        }
 
-            auto cachedShapeA = document->cacheModel(sourceName);
-            auto cachedShapeB = document->cacheModel(targetName);
+        emit(progressText(QString("Cached pairs: %1 / %2").arg(pairs.size() - pendingPairs.size()).arg(pairs.size())));
 
-            QString sourceShape = "CACHED_" + sourceName;
-            QString targetShape = "CACHED_" + targetName;
+        // Every (source, target, direction) search is an independent job
+        int numDirections = options["roundtrip"].toBool() ? 2 : 1;
+        int numJobs = pendingPairs.size() * numDirections;
 
-            QVariantMap options;
-            options["roundtrip"].setValue(true);
-            options["k"].setValue( k );
-            options["isQuietMode"].setValue(true);
-            options["isManyTypesJobs"].setValue(true);
-            options["isAllowCutsJoins"].setValue(true);
+        QVector< QVector<QVariantMap> > jobReports(numJobs);
+        QVector<QAtomicInt> pairJobsDone(pendingPairs.size());
+        QAtomicInt numCompleted(0);
 
-            int numJobs = 0;
+        // Jobs vary a lot in cost, hand them out one at a time to idle threads
+        #pragma omp parallel for schedule(dynamic, 1)
+        for(int job = 0; job < numJobs; job++)
+        {
+            int pendingIndex = job / numDirections;
+            int p = pendingPairs[pendingIndex];
+            auto pair = pairs[p];
+            int direction = job % numDirections;
 
-            QVector< QVector<QVariantMap> > reports;
+            int a = (direction == 0) ? pair.first : pair.second;
+            int b = (direction == 0) ? pair.second : pair.first;
 
-            // Perform correspondence search
+            QString sourceShape = "CACHED_" + catModels.at(a);
+            QString targetShape = "CACHED_" + catModels.at(b);
+
+            // Each job works on its own copies of the shapes
+            auto bp = QSharedPointer<BatchProcess>(new BatchProcess(sourceShape, targetShape, options));
+            bp->cachedShapeA = QSharedPointer<Structure::ShapeGraph>(document->cloneAsShapeGraph(cachedShapes[a]));
+            bp->cachedShapeB = QSharedPointer<Structure::ShapeGraph>(document->cloneAsShapeGraph(cachedShapes[b]));
+            bp->jobUID = direction;
+            bp->run();
+
+            jobReports[job] = bp->jobReports;
+
+            // Last direction of a pair to finish persists the pair, so a crash loses at most the running jobs
+            if(pairJobsDone[pendingIndex].fetchAndAddOrdered(1) + 1 == numDirections)
             {
-                // First pass source to target
-                {
-                    auto bp = QSharedPointer<BatchProcess>(new BatchProcess(sourceShape, targetShape, options));
-                    bp->cachedShapeA = QSharedPointer<Structure::ShapeGraph>(document->cloneAsShapeGraph(cachedShapeA));
-                    bp->cachedShapeB = QSharedPointer<Structure::ShapeGraph>(document->cloneAsShapeGraph(cachedShapeB));
-                    bp->jobUID = numJobs++;
-                    bp->run();
-                    reports << bp->jobReports;
-                }
+                QVector< QVector<QVariantMap> > reports;
+                for(int d = 0; d < numDirections; d++)
+                    reports << jobReports[pendingIndex * numDirections + d];
 
-                // Second pass target to source
-                if (options["roundtrip"].toBool())
-                {
-                    auto bp2 = QSharedPointer<BatchProcess>(new BatchProcess(targetShape, sourceShape, options));
-                    bp2->cachedShapeA = QSharedPointer<Structure::ShapeGraph>(document->cloneAsShapeGraph(cachedShapeB));
-                    bp2->cachedShapeB = QSharedPointer<Structure::ShapeGraph>(document->cloneAsShapeGraph(cachedShapeA));
-                    bp2->jobUID = numJobs++;
-                    bp2->run();
-                    reports << bp2->jobReports;
-                }
+                pairResults[p] = bestReport(reports);
+                cache.store(shapeHashes.at(pair.first), shapeHashes.at(pair.second), pairResults[p]);
             }
 
-            // Look at reports
-            double minEnergy = 1.0;
-            int totalTime = 0;
-            QVariantMap minJob;
-            for (auto & reportVec : reports){
-                for (auto & report : reportVec){
-                    totalTime += report["search_time"].toInt();
-                    double c = report["min_cost"].toDouble();
-                    if (c < minEnergy){
-                        minEnergy = c;
-                        minJob = report;
-                    }
-                }
-            }
+            int c = numCompleted.fetchAndAddOrdered(1) + 1;
+            double done = numProcessed + (pairs.size() - pendingPairs.size()) + (double(c) / numDirections);
+            emit(progressText(QString("Processed: %1-%2").arg(catModels.at(a)).arg(catModels.at(b))));
+            emit(progress(loadShapesPercent + (computeCorrespodPercent * (done / numToProcess))));
+        }
+
+        numProcessed += pairs.size();
+
+        // Record results in pair order so the outcome matches a serial run
+        for(int p = 0; p < pairs.size(); p++)
+        {
+            QString sourceName = catModels.at(pairs[p].first);
+            QString targetName = catModels.at(pairs[p].second);
+
+            document->datasetMatching[sourceName][targetName] = pairResults[p];
+        }
+
+        return pairResults;
+    };
+
+    int n = catModels.size();
+
+    // A shard only fills the pair cache with its share of all pairs, landmarks need every result
+    // so the matching file is written by a later unsharded run which finds all pairs cached
+    if(shardCount > 1)
+    {
+        QVector< QPair<int,int> > pairs;
+        int p = 0;
+        for(int i = 0; i < n; i++)
+            for(int j = i+1; j < n; j++)
+                if(p++ % shardCount == shardIndex) pairs << qMakePair(i, j);
+
+        numToProcess = pairs.size();
+        matchPairs(pairs);
+
+        emit(finished());
+        return;
+    }
 
-            auto firstReport = reports.front().front();
-            if (minJob["job_uid"].toInt() != firstReport["job_uid"].toInt()) minJob["isReversed"].setValue(true);
+    // Large categories only match the pairs that have a landmark, Explore places the rest from those
+    QSettings settings;
+    int numLandmarks = std::max(3, settings.value("exploreLandmarks", 50).toInt());
+    bool isLandmarks = n >= settings.value("exploreLandmarkShapes", 300).toInt() && numLandmarks < n;
 
-            // Record result
-            document->datasetMatching[sourceName][targetName] = minJob;
+    QString landmarks_file = document->datasetPath + "/" + document->currentCategory + "_landmarks.txt";
+    QFile::remove(landmarks_file);
+    document->landmarks.remove(document->currentCategory);
 
-            c++;
-            emit(progress(loadShapesPercent + (computeCorrespodPercent * (double(c) / numPairwise))));
+    if(!isLandmarks)
+    {
+        // Unordered pairs, in the same order the serial loop used to visit them
+        QVector< QPair<int,int> > pairs;
+        for(int i = 0; i < n; i++)
+            for(int j = i+1; j < n; j++)
+                pairs << qMakePair(i, j);
+
+        numToProcess = pairs.size();
+        matchPairs(pairs);
+    }
+    else
+    {
+        // Max-min landmarks: the next landmark is the shape farthest from all landmarks so far
+        QVector<bool> isLandmark(n, false);
+        QVector<double> nearestLandmark(n, std::numeric_limits<double>::max());
+        QStringList chosen;
+
+        numToProcess = numLandmarks * n - (numLandmarks * (numLandmarks + 1)) / 2;
+
+        int next = 0;
+        for(int l = 0; l < numLandmarks && next >= 0; l++)
+        {
+            isLandmark[next] = true;
+            chosen << catModels.at(next);
+
+            // Pairs with earlier landmarks were matched in their rounds
+            QVector< QPair<int,int> > column;
+            for(int j = 0; j < n; j++)
+                if(!isLandmark[j]) column << qMakePair(std::min(next, j), std::max(next, j));
+
+            auto results = matchPairs(column);
+
+            for(int c = 0; c < column.size(); c++)
+            {
+                int j = (column[c].first == next) ? column[c].second : column[c].first;
+                nearestLandmark[j] = std::min(nearestLandmark[j], results[c]["min_cost"].toDouble());
+            }
+
+            next = -1;
+            for(int j = 0; j < n; j++)
+                if(!isLandmark[j] && (next < 0 || nearestLandmark[j] > nearestLandmark[next])) next = j;
         }
+
+        document->landmarks[document->currentCategory] = chosen;
+
+        QFile file(landmarks_file);
+        if(file.open(QFile::WriteOnly | QFile::Text))
+            QTextStream(&file) << chosen.join("\n");
     }
 
     // Save results to disk
@@ -125,11 +267,13 @@ void DocumentAnalyzeWorker::processShapeDataset()
 	 
     // Get names of shapes of selected category into memory
     auto catModels = document->categories[ document->currentCategory ].toStringList();
+    Document::PinnedModels pinned(document, catModels);
 	  
     // Load all shapes into memory
-    for(int i = 0; i < catModels.size(); i++)
+    auto loading = document->prefetchCategory(document->currentCategory);
+    for(int i = 0; i < loading.size(); i++)
     {
-        document->cacheModel(catModels.at(i));
+        loading[i].waitForFinished();
 
         emit(progress(loadShapesPercent * (double(i) / (catModels.size()-1))));
     }
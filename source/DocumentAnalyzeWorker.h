@@ -4,9 +4,12 @@
 class DocumentAnalyzeWorker : public QObject{
     Q_OBJECT
 public:
-    DocumentAnalyzeWorker(Document * d) : document(d){}
+    DocumentAnalyzeWorker(Document * d) : document(d), shardIndex(0), shardCount(1){}
     Document * document;
 
+    // Pairwise matching of pairs k, k + n, ... only, the results of all shards meet in the pair cache
+    int shardIndex, shardCount;
+
 public slots:
     void processAllPairWise();
     void processShapeDataset();
@@ -0,0 +1,83 @@
+#include "Document.h"
+#include "Model.h"
+#include "Viewer.h"
+#include "DocumentAnalyzeWorker.h"
+
+#include <QApplication>
+#include <QDesktopWidget>
+#include <QProgressDialog>
+#include <QThread>
+
+// Progress dialogs and drawing, the parts of Document that need widgets and a GL context
+
+void Document::analyze(QString categoryName)
+{
+    if(!categories.keys().contains(categoryName)) return;
+
+    // Create progress bar
+    auto bar = new QProgressDialog("Please wait...", QString(), 0, 100, 0);
+    bar->setWindowTitle("Processing");
+    bar->show();
+    QRect screenGeometry = QApplication::desktop()->screenGeometry();
+    int x = (screenGeometry.width()-bar->width()) / 2;
+    int y = (screenGeometry.height()-bar->height()) / 2;
+    bar->move(x, y);
+
+    auto worker = new DocumentAnalyzeWorker(this);
+
+    QThread* thread = new QThread;
+    worker->moveToThread(thread);
+    connect(thread, SIGNAL (started()), worker, SLOT (processShapeDataset()));
+    connect(worker, SIGNAL (finished()), thread, SLOT (quit()));
+    connect(worker, SIGNAL (finished()), this, SLOT (sayCategoryAnalysisDone()));
+    connect(worker, SIGNAL (finished()), bar, SLOT (deleteLater()));
+    connect(worker, SIGNAL (finished()), worker, SLOT (deleteLater()));
+    connect(thread, SIGNAL (finished()), thread, SLOT (deleteLater()));
+
+    // Connect progress bar to worker
+    bar->connect(worker, SIGNAL(progress(int)), SLOT(setValue(int)));
+    bar->connect(worker, SIGNAL(progressText(QString)), SLOT(setLabelText(QString)));
+
+    thread->start(QThread::HighestPriority);
+}
+
+void Document::computePairwise(QString categoryName)
+{
+    if(!categories.keys().contains(categoryName)) return;
+
+    // Create progress bar
+    auto bar = new QProgressDialog("Please wait...", QString(), 0, 100, 0);
+    bar->setWindowTitle("Processing");
+    bar->show();
+    QRect screenGeometry = QApplication::desktop()->screenGeometry();
+    int x = (screenGeometry.width()-bar->width()) / 2;
+    int y = (screenGeometry.height()-bar->height()) / 2;
+    bar->move(x, y);
+
+    auto worker = new DocumentAnalyzeWorker(this);
+
+    QThread* thread = new QThread;
+
+    worker->moveToThread(thread);
+    connect(thread, SIGNAL (started()), worker, SLOT (processAllPairWise()));
+    connect(worker, SIGNAL (finished()), thread, SLOT (quit()));
+    connect(worker, SIGNAL (finished()), this, SLOT (sayPairwiseAnalysisDone()));
+    connect(worker, SIGNAL (finished()), bar, SLOT (deleteLater()));
+    connect(worker, SIGNAL (finished()), worker, SLOT (deleteLater()));
+    connect(thread, SIGNAL (finished()), thread, SLOT (deleteLater()));
+
+    // Connect progress bar to worker
+    bar->connect(worker, SIGNAL(progress(int)), SLOT(setValue(int)));
+    bar->connect(worker, SIGNAL(progressText(QString)), SLOT(setLabelText(QString)));
+
+    thread->start(QThread::HighestPriority);
+}
+
+void Document::drawModel(QString name, QWidget *widget)
+{
+    auto glwidget = (Viewer*)widget;
+    if (glwidget == nullptr) return;
+
+    auto m = getModel(name);
+    if(m != nullptr) m->draw(glwidget);
+}
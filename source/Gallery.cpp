@@ -118,6 +118,7 @@ QRectF Gallery::nextItemRect()
 void Gallery::clearThumbnails()
 {
     for(auto t : items) t->deleteLater();
+    items.clear();
 }
 
 QVector<Thumbnail *> Gallery::getSelected()
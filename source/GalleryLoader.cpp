@@ -0,0 +1,116 @@
+#include "GalleryLoader.h"
+#include "Gallery.h"
+#include "Document.h"
+#include "Model.h"
+#include "ThumbnailCache.h"
+
+#include <QGraphicsScene>
+#include <QtConcurrent>
+#include <QFutureWatcher>
+
+GalleryLoader::GalleryLoader(Document * document, Gallery * gallery, QVector3D cameraPos, QMatrix4x4 cameraMatrix, QObject * parent)
+    : QObject(parent), document(document), gallery(gallery), cameraPos(cameraPos), cameraMatrix(cameraMatrix), numPending(0)
+{
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+GalleryLoader::~GalleryLoader()
+{
+    cancel();
+    pool.clear();
+    pool.waitForDone();
+}
+
+void GalleryLoader::cancel()
+{
+    isCancelled.store(1);
+}
+
+void GalleryLoader::discard()
+{
+    cancel();
+    pool.clear();
+
+    // Nothing is delivered anymore, and the loader no longer belongs to the tool that replaces it
+    disconnect();
+    setParent(nullptr);
+
+    QtConcurrent::run([this](){
+        pool.waitForDone();
+        deleteLater();
+    });
+}
+
+void GalleryLoader::load(QStringList names)
+{
+    for (auto targetName : names)
+    {
+        auto t = gallery->addTextItem(targetName);
+
+        QVariantMap data = t->data;
+        data["targetName"].setValue(targetName);
+        t->setData(data);
+
+        t->setCamera(cameraPos, cameraMatrix);
+        t->setFlag(QGraphicsItem::ItemIsSelectable);
+
+        emit(thumbnailAdded(t));
+
+        // The pool takes shapes in gallery order, so the first rows fill in first
+        auto doc = document;
+        auto camera = cameraMatrix;
+        auto size = t->rect.size().toSize();
+        auto cancelled = &isCancelled;
+        auto future = QtConcurrent::run(&pool, [=](){ return prepare(doc, targetName, camera, size, cancelled); });
+        numPending++;
+
+        QPointer<Thumbnail> thumbnail(t);
+        auto watcher = new QFutureWatcher<Entry>(this);
+        connect(watcher, &QFutureWatcher<Entry>::finished, this, [=](){
+            watcher->deleteLater();
+            if (isCancelled.load()) return;
+            apply(thumbnail, watcher->result());
+            if (--numPending == 0) emit(finished());
+        });
+        watcher->setFuture(future);
+    }
+
+    if (gallery->scene()) gallery->scene()->update(gallery->sceneBoundingRect());
+}
+
+GalleryLoader::Entry GalleryLoader::prepare(Document * document, QString name, QMatrix4x4 cameraMatrix, QSize size, QAtomicInt * isCancelled)
+{
+    Entry entry;
+    if (isCancelled->load()) return entry;
+
+    // A current cached image saves loading the shape
+    entry.cacheFile = document->thumbnailFile(name, cameraMatrix, size);
+    if (ThumbnailCache::load(entry.cacheFile, entry.image)) return entry;
+    if (isCancelled->load()) return entry;
+
+    // Pinned so the model is not evicted while its parts are converted
+    document->pinModel(name);
+    auto model = document->cacheModel(name);
+    if (model)
+    {
+        for (auto n : model->nodes)
+            entry.parts << Thumbnail::toBasicMesh(model->getMesh(n->id), n->vis_property["color"].value<QColor>());
+    }
+    document->unpinModel(name);
+
+    return entry;
+}
+
+void GalleryLoader::apply(QPointer<Thumbnail> t, const Entry & entry)
+{
+    // Removed by a newer fill of the gallery
+    if (t.isNull()) return;
+
+    if (!t->setCacheFile(entry.cacheFile, entry.image))
+    {
+        // Add parts of target shape
+        for (auto & part : entry.parts) t->addAuxMesh(part);
+    }
+
+    t->update();
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <QObject>
+#include <QPointer>
+#include <QThreadPool>
+#include <QAtomicInt>
+
+#include "Thumbnail.h"
+
+class Document;
+class Gallery;
+
+// Fills a gallery with the shapes of a category. Thumbnails are added right away in category
+// order, cached images and parts are read on worker threads and handed over as each shape is done
+class GalleryLoader : public QObject
+{
+    Q_OBJECT
+public:
+    GalleryLoader(Document * document, Gallery * gallery, QVector3D cameraPos, QMatrix4x4 cameraMatrix, QObject * parent = 0);
+    ~GalleryLoader();
+
+    void load(QStringList names);
+    void cancel();
+
+    // Cancels and deletes the loader once its running workers are done, without waiting for them
+    void discard();
+
+    // What a worker prepared for one thumbnail
+    struct Entry{
+        QString cacheFile;
+        QImage image;
+        QVector<Thumbnail::QBasicMesh> parts;
+    };
+
+protected:
+    Document * document;
+    Gallery * gallery;
+    QVector3D cameraPos;
+    QMatrix4x4 cameraMatrix;
+
+    // Workers stop picking up shapes once cancelled, the destructor waits for the running ones
+    // while discard leaves that to a helper thread
+    QAtomicInt isCancelled;
+    QThreadPool pool;
+    int numPending;
+
+    static Entry prepare(Document * document, QString name, QMatrix4x4 cameraMatrix, QSize size, QAtomicInt * isCancelled);
+    void apply(QPointer<Thumbnail> t, const Entry & entry);
+
+signals:
+    void thumbnailAdded(Thumbnail*);
+    void finished();
+};
@@ -1,10 +1,13 @@
 #include "Model.h"
-#include "Viewer.h"
 #include "GeometryHelper.h"
 
+#include <limits>
+#include <atomic>
+
 using namespace opengp;
 
 #include "ModelMesher.h"
+#include "ModelConnector.h"
 
 Q_DECLARE_METATYPE(Array1D_Vector3);
 Q_DECLARE_METATYPE(Vector3);
@@ -14,6 +17,30 @@ Model::Model(QObject *parent) : QObject(parent), Structure::ShapeGraph(""), acti
 
 }
 
+Model::~Model()
+{
+
+}
+
+// Versions are unique over all models, a new mesh allocated where a freed one was never matches old caches
+static std::atomic<int> nextMeshVersion(0);
+
+void Model::setNodeMesh(Structure::Node * n, QSharedPointer<SurfaceMeshModel> mesh)
+{
+    n->property["mesh"].setValue(mesh);
+    invalidateNodeMesh(n->id);
+}
+
+void Model::invalidateNodeMesh(QString nid)
+{
+    meshVersions[nid] = ++nextMeshVersion;
+}
+
+void Model::invalidateMeshes()
+{
+    for(auto n : nodes) meshVersions[n->id] = ++nextMeshVersion;
+}
+
 void Model::createCurveFromPoints(QVector<QVector3D> & points)
 {
     if(points.size() < 2) return;
@@ -210,6 +237,7 @@ QVector<Structure::Node *> Model::makeDuplicates(Structure::Node *n, QString dup
         auto cloneNode = result[i];
         cloneNode->id = n->id + randomAlpha + QString::number(i+2);
         cloneNode->property["mesh_filename"].setValue(QString("meshes/%1.obj").arg(cloneNode->id));
+        invalidateNodeMesh(cloneNode->id);
     }
 
     return result;
@@ -356,267 +384,109 @@ void Model::placeOnGround()
 {
     this->normalize();
     this->moveBottomCenterToOrigin();
+    invalidateMeshes();
 }
 
-void Model::selectPart(QVector3D orig, QVector3D dir)
+static void meshArrays(SurfaceMeshModel * mesh, std::vector<Vector3> & points, std::vector<Eigen::Vector3i> & triangles)
 {
-    QMap< double, QPair<int, Vector3> > isects;
-    QMap< double, QString > isectNode;
-
-    Vector3 origin (orig[0], orig[1], orig[2]);
-    Vector3 direction (dir[0], dir[1], dir[2]);
-    Vector3 ipoint;
-
-    for(auto n : nodes)
-    {
-        auto nodeMesh = getMesh(n->id);
-        if(!nodeMesh) continue;
-
-        nodeMesh->updateBoundingBox();
-
-        for(auto f : nodeMesh->faces())
-        {
-            std::vector<Vector3> tri;
-            for(auto v : nodeMesh->vertices(f))
-                tri.push_back( nodeMesh->vertex_coordinates()[v] );
-
-            if( GeometryHelper::intersectRayTri(tri, origin, direction, ipoint) )
-            {
-                double dist = (origin - ipoint).norm();
-                isects[dist] = qMakePair(f.idx(), ipoint);
-                isectNode[dist] = n->id;
-            }
+    auto mesh_points = mesh->vertex_coordinates();
+
+    points.resize(mesh->n_vertices());
+    for(auto v : mesh->vertices()) points[v.idx()] = mesh_points[v];
+
+    triangles.clear();
+    triangles.reserve(mesh->n_faces());
+    for(auto f : mesh->faces()){
+        Eigen::Vector3i tri;
+        int i = 0;
+        for(auto v : mesh->vertices(f)){
+            if(i == 3) break;
+            tri[i++] = v.idx();
         }
-    }
-
-    // Only consider closest hit
-    if(isects.size())
-    {
-        double minDist = isects.keys().front();
-        activeNode = getNode(isectNode[minDist]);
-    }
-    else
-    {
-        activeNode = nullptr;
+        triangles.push_back(tri);
     }
 }
 
-void Model::deselectAll()
+void Model::updatePickingBVH()
 {
-    activeNode = nullptr;
-    tempNodes.clear();
-}
+    bool isChanged = false;
 
-void Model::draw(Viewer *glwidget)
-{
-    // Collect meshes
-    QVector<SurfaceMeshModel *> meshes;
-    for(auto n : nodes){
+    QVector<Structure::Node*> pickNodes;
+    for(auto n : nodes)
+    {
         auto mesh = getMesh(n->id);
-        if(mesh != nullptr) { meshes << mesh; } 
-		else
-        {
-            if(n->type() == Structure::CURVE)
-            {
-                // Draw as a basic 3D curve
-                auto nodeColor = n->vis_property["color"].value<QColor>();
-                QVector<QVector3D> lines;
-                auto points = n->controlPoints();
-                for(size_t i = 1; i < points.size(); i++){
-                    lines << QVector3D(points[i-1][0],points[i-1][1],points[i-1][2]);
-                    lines << QVector3D(points[i][0],points[i][1],points[i][2]);
-                }
-                glwidget->glLineWidth(6);
-                glwidget->drawLines(lines, nodeColor, glwidget->pvm, "lines");
-            }
+        if(!mesh || mesh->n_faces() < 1) continue;
+        pickNodes << n;
 
-            if(n->type() == Structure::SHEET)
-            {
-                auto & sheet = ((Structure::Sheet*) n)->surface;
-
-                // Build surface geometry if needed
-                if(sheet.quads.empty())
-                {
-                    double resolution = (sheet.mCtrlPoint.front().front()
-                                         - sheet.mCtrlPoint.back().back()).norm() * 0.1;
-                    sheet.generateSurfaceQuads( resolution );
-                }
-
-                // Draw surface as triangles
-                QVector<QVector3D> points, normals;
-                for(auto quad : sheet.quads){
-                    QVector<QVector3D> quad_points, quad_normals;
-
-                    for(int i = 0; i < 4; i++){
-                        quad_points << QVector3D(quad.p[i][0],quad.p[i][1],quad.p[i][2]);
-                        quad_normals << QVector3D(quad.n[i][0],quad.n[i][1],quad.n[i][2]);
-                    }
+        auto & part = partBVHs[n];
+        int version = meshVersions.value(n->id, 0);
 
-                    // Add two triangles of the quad
-                    points<<quad_points[0]; normals<<quad_normals[0];
-                    points<<quad_points[1]; normals<<quad_normals[1];
-                    points<<quad_points[2]; normals<<quad_normals[2];
+        std::vector<Vector3> points;
+        std::vector<Eigen::Vector3i> triangles;
 
-                    points<<quad_points[0]; normals<<quad_normals[0];
-                    points<<quad_points[2]; normals<<quad_normals[2];
-                    points<<quad_points[3]; normals<<quad_normals[3];
-                }
-
-                auto nodeColor = n->vis_property["color"].value<QColor>();
-                glwidget->drawTriangles(nodeColor, points, normals, glwidget->pvm);
-                glwidget->drawPoints(points,nodeColor,glwidget->pvm);
-            }
+        // Same connectivity only needs a refit
+        if(part.bvh.isNull() || part.mesh != mesh || part.numVertices != int(mesh->n_vertices()) || part.numFaces != int(mesh->n_faces()))
+        {
+            meshArrays(mesh, points, triangles);
+            part.bvh = QSharedPointer<MeshBVH>(new MeshBVH);
+            part.bvh->build(points, triangles);
         }
-    }
-
-    if(meshes.empty()) return;
-
-    // Draw meshes:
-    glwidget->glEnable(GL_DEPTH_TEST);
-    //glwidget->glEnable(GL_CULL_FACE);
-    glwidget->glCullFace(GL_BACK);
-
-    // Activate shader
-    auto & program = *glwidget->shaders["mesh"];
-    program.bind();
-
-    // Attributes
-    int vertexLocation = program.attributeLocation("vertex");
-    int normalLocation = program.attributeLocation("normal");
-    int colorLocation = program.attributeLocation("color");
+        else if(part.version != version)
+        {
+            meshArrays(mesh, points, triangles);
+            part.bvh->refit(points);
+        }
+        else continue;
 
-    program.enableAttributeArray(vertexLocation);
-    program.enableAttributeArray(normalLocation);
-    program.enableAttributeArray(colorLocation);
+        part.mesh = mesh;
+        part.version = version;
+        part.numVertices = mesh->n_vertices();
+        part.numFaces = mesh->n_faces();
+        isChanged = true;
+    }
 
-    // Uniforms
-    int matrixLocation = program.uniformLocation("matrix");
-    int lightPosLocation = program.uniformLocation("lightPos");
-    int viewPosLocation = program.uniformLocation("viewPos");
-    int lightColorLocation = program.uniformLocation("lightColor");
+    // Drop removed parts
+    for(auto it = partBVHs.begin(); it != partBVHs.end();){
+        if(pickNodes.contains(it.key())) ++it;
+        else it = partBVHs.erase(it);
+    }
 
-    program.setUniformValue(matrixLocation, glwidget->pvm);
-    program.setUniformValue(lightPosLocation, glwidget->eyePos);
-    program.setUniformValue(viewPosLocation, glwidget->eyePos);
-    program.setUniformValue(lightColorLocation, QVector3D(1,1,1));
+    if(!isChanged && pickNodes == pickingNodes) return;
 
-    // Add visualized nodes for duplication and such
-    auto allNodes = nodes;
-    for(auto n : tempNodes) allNodes.push_back(n.data());
+    std::vector<BVH::Box> boxes;
+    for(auto n : pickNodes) boxes.push_back(partBVHs[n].bvh->bounds());
 
-    // Draw parts as meshes
-    for(auto n : allNodes)
-    {
-        auto mesh = n->property["mesh"].value< QSharedPointer<SurfaceMeshModel> >().data();
-        if(mesh == nullptr || mesh->n_faces() < 1) continue;
-        if(n->vis_property["isHidden"].toBool()) continue;
-
-        auto nodeColor = n->vis_property["color"].value<QColor>();
-        auto ncolor = Eigen::Vector3f(nodeColor.redF(), nodeColor.greenF(), nodeColor.blueF());
-
-        bool isSmoothShading = n->vis_property["isSmoothShading"].toBool();
-
-        // Pack geometry, normals, and colors
-        QVector<GLfloat> vertex, normal, color;
-
-        auto mesh_points = mesh->vertex_coordinates();
-        auto mesh_normals = mesh->vertex_normals();
-        auto mesh_fnormals = mesh->face_normals();
-
-        int v_count = 0;
-
-        // Pack mesh faces
-        for(auto f : mesh->faces()){
-            for(auto vf : mesh->vertices(f)){
-                for(int i = 0; i < 3; i++){
-                    // Coordinate
-                    vertex << mesh_points[vf][i];
-                    // Color
-                    color << ncolor[i];
-                    // Normal
-                    if (!isSmoothShading) normal << mesh_fnormals[f][i];
-                    else normal << mesh_normals[vf][i];
-                    v_count++;
-                }
-            }
-        }
+    if(pickNodes == pickingNodes) pickingBVH.refit(boxes);
+    else pickingBVH.build(boxes);
 
-        // Shader data
-        program.setAttributeArray(vertexLocation, &vertex[0], 3);
-        program.setAttributeArray(normalLocation, &normal[0], 3);
-        program.setAttributeArray(colorLocation, &color[0], 3);
-
-        // Draw
-        glwidget->glDrawArrays(GL_TRIANGLES, 0, mesh->n_faces() * 3);
-    }
-
-    program.disableAttributeArray(vertexLocation);
-    program.disableAttributeArray(normalLocation);
-    program.disableAttributeArray(colorLocation);
+    pickingNodes = pickNodes;
+}
 
-    program.release();
+void Model::selectPart(QVector3D orig, QVector3D dir)
+{
+    Vector3 origin (orig[0], orig[1], orig[2]);
+    Vector3 direction (dir[0], dir[1], dir[2]);
 
-    // Draw bounding box around active part
-    if(activeNode != nullptr && getMesh(activeNode->id) != nullptr)
-    {
-        auto mesh = getMesh(activeNode->id);
-        auto box = mesh->bbox();
-
-        QVector<Eigen::Vector3d> corners;
-        corners<<box.corner(Eigen::AlignedBox3d::BottomLeftFloor);
-        corners<<box.corner(Eigen::AlignedBox3d::BottomRightFloor);
-        corners<<box.corner(Eigen::AlignedBox3d::TopLeftFloor);
-        corners<<box.corner(Eigen::AlignedBox3d::TopRightFloor);
-        corners<<box.corner(Eigen::AlignedBox3d::BottomLeftCeil);
-        corners<<box.corner(Eigen::AlignedBox3d::BottomRightCeil);
-        corners<<box.corner(Eigen::AlignedBox3d::TopLeftCeil);
-        corners<<box.corner(Eigen::AlignedBox3d::TopRightCeil);
-
-        QVector<QVector3D> lines;
-        auto addLine = [&](Eigen::Vector3d a, Eigen::Vector3d b){
-            Vector3 dir = (a - b).normalized() * 0.025;
-            lines << toQVector3D(a);
-            lines << toQVector3D(a - dir);
-            lines << toQVector3D(b);
-            lines << toQVector3D(b + dir);
-        };
-
-        addLine(corners[0], corners[1]);
-        addLine(corners[0], corners[2]);
-        addLine(corners[0], corners[4]);
-        addLine(corners[1], corners[3]);
-        addLine(corners[1], corners[5]);
-        addLine(corners[2], corners[3]);
-        addLine(corners[2], corners[6]);
-        addLine(corners[3], corners[7]);
-        addLine(corners[4], corners[5]);
-        addLine(corners[4], corners[6]);
-        addLine(corners[5], corners[7]);
-        addLine(corners[6], corners[7]);
-
-        QColor color(255,255,255,150);
-
-        glwidget->glLineWidth(2);
-        glwidget->drawLines(lines, color, glwidget->pvm, "lines");
-    }
+    updatePickingBVH();
 
-    glwidget->glDisable(GL_DEPTH_TEST);
-    //glwidget->glDisable(GL_CULL_FACE);
+    // Only consider closest hit
+    Structure::Node * hitNode = nullptr;
+    double tMax = std::numeric_limits<double>::max();
 
-    if(ShapeGraph::property["showEdges"].toBool())
-    {
-        QVector<QVector3D> lines;
+    pickingBVH.raycast(origin, direction, tMax, [&](int i, double & tClosest){
+        int triangle;
+        if(!partBVHs[pickingNodes[i]].bvh->raycast(origin, direction, tClosest, triangle)) return false;
+        hitNode = pickingNodes[i];
+        return true;
+    });
 
-        for(auto e : edges)
-        {
-            lines << toQVector3D(e->position(e->n1->id));
-            lines << toQVector3D(e->position(e->n2->id));
-        }
+    activeNode = hitNode;
+}
 
-        glwidget->glLineWidth(4);
-        QColor color(255,0,255,100);
-        glwidget->drawLines(lines, color, glwidget->pvm, "lines");
-    }
+void Model::deselectAll()
+{
+    activeNode = nullptr;
+    tempNodes.clear();
 }
 
 void Model::storeActiveNodeGeometry()
@@ -642,6 +512,8 @@ void Model::storeActiveNodeGeometry()
         Array1D_Vector3 meshPoints;
         for (auto v : mesh->vertices()) meshPoints.push_back(mesh->vertex_coordinates()[v]);
         n->property["restMeshGeometry"].setValue(meshPoints);
+
+        ModelConnector::storeRestPose(this, n);
     }
 }
 
@@ -684,6 +556,10 @@ void Model::transformActiveNodeGeometry(QMatrix4x4 transform)
         mesh->update_face_normals();
         mesh->update_vertex_normals();
         mesh->updateBoundingBox();
+
+        int version = meshVersion(n->id);
+        invalidateNodeMesh(n->id);
+        ModelConnector::transformCollisionModel(this, n, transform, n_centroid, version);
     }
 }
 
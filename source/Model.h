@@ -2,18 +2,30 @@
 
 #include <QObject>
 #include <QMatrix4x4>
+#include <QHash>
 #include "ShapeGraph.h"
+#include "BVH.h"
 
 class Viewer;
+class QOpenGLContext;
 
 class Model : public QObject, public Structure::ShapeGraph
 {
     Q_OBJECT
 public:
     explicit Model(QObject *parent = 0);
+    ~Model();
 
     void draw(Viewer * glwidget);
 
+    // Replace a part's mesh, always go through here so cached buffers and hierarchies are rebuilt
+    void setNodeMesh(Structure::Node * n, QSharedPointer<opengp::SurfaceMesh::SurfaceMeshModel> mesh);
+
+    // GPU buffers of part meshes are kept until the mesh changes, call after editing a mesh in place
+    void invalidateNodeMesh(QString nid);
+    void invalidateMeshes();
+    int meshVersion(QString nid) const { return meshVersions.value(nid, 0); }
+
     void createCurveFromPoints(QVector<QVector3D> &points);
     void createSheetFromPoints(QVector<QVector3D> &points);
 
@@ -41,6 +53,23 @@ public:
 protected:
     QVector< Structure::Node* > makeDuplicates(Structure::Node* n, QString duplicationOp);
 
+    // Per context since vertex arrays are not shared between contexts, see ModelDraw.cpp
+    struct NodeBuffers;
+    struct ContextBuffers;
+    QHash< QOpenGLContext*, QSharedPointer<ContextBuffers> > nodeBuffers;
+    QHash< QString, int > meshVersions;
+
+    // Picking, per part hierarchies under one over the part bounds
+    struct PartBVH{
+        QSharedPointer<MeshBVH> bvh;
+        opengp::SurfaceMesh::SurfaceMeshModel * mesh;
+        int version, numVertices, numFaces;
+    };
+    QHash< Structure::Node*, PartBVH > partBVHs;
+    QVector< Structure::Node* > pickingNodes;
+    BVH pickingBVH;
+    void updatePickingBVH();
+
 public slots :
 	void transformActiveNodeGeometry(QMatrix4x4 transform);
 signals:
@@ -0,0 +1,116 @@
+#include "ModelCache.h"
+#include "Model.h"
+
+#include <limits>
+
+ModelCache::ModelCache(qint64 budgetBytes) : hits(0), misses(0), evictions(0),
+    budgetBytes(budgetBytes), totalBytes(0), useClock(0)
+{
+
+}
+
+QSharedPointer<Model> ModelCache::get(const QString & name)
+{
+    auto it = entries.find(name);
+    if (it == entries.end()){
+        misses++;
+        return QSharedPointer<Model>();
+    }
+
+    hits++;
+    it->lastUse = ++useClock;
+    return it->model;
+}
+
+void ModelCache::insert(const QString & name, QSharedPointer<Model> model)
+{
+    remove(name);
+
+    Entry entry;
+    entry.model = model;
+    entry.bytes = estimateSize(model.data());
+    entry.lastUse = ++useClock;
+
+    entries[name] = entry;
+    totalBytes += entry.bytes;
+
+    // The new model is about to be handed out, never evict it right away
+    evict(name);
+}
+
+void ModelCache::remove(const QString & name)
+{
+    auto it = entries.find(name);
+    if (it == entries.end()) return;
+    totalBytes -= it->bytes;
+    entries.erase(it);
+}
+
+void ModelCache::clear()
+{
+    entries.clear();
+    totalBytes = 0;
+}
+
+void ModelCache::pin(const QString & name)
+{
+    pins[name]++;
+}
+
+void ModelCache::unpin(const QString & name)
+{
+    auto it = pins.find(name);
+    if (it == pins.end()) return;
+    if (--it.value() <= 0) pins.erase(it);
+
+    evict();
+}
+
+void ModelCache::setBudget(qint64 bytes)
+{
+    budgetBytes = bytes;
+    evict();
+}
+
+void ModelCache::evict(const QString & keep)
+{
+    while (totalBytes > budgetBytes)
+    {
+        // Oldest unpinned entry
+        QString oldest;
+        quint64 oldestUse = std::numeric_limits<quint64>::max();
+        for (auto it = entries.begin(); it != entries.end(); ++it){
+            if (it.key() == keep || isPinned(it.key())) continue;
+            if (it->lastUse < oldestUse){
+                oldestUse = it->lastUse;
+                oldest = it.key();
+            }
+        }
+        if (oldest.isNull()) return;
+
+        remove(oldest);
+        evictions++;
+    }
+}
+
+qint64 ModelCache::estimateSize(Model * model)
+{
+    if (model == nullptr) return 0;
+
+    qint64 bytes = sizeof(Model);
+
+    for (auto n : model->nodes)
+    {
+        bytes += n->controlPoints().size() * sizeof(Vector3);
+
+        auto mesh = model->getMesh(n->id);
+        if (mesh == nullptr) continue;
+
+        // Connectivity plus the usual point, normal and color properties
+        bytes += qint64(mesh->n_vertices()) * (3 * sizeof(Vector3) + 2 * sizeof(int));
+        bytes += qint64(mesh->n_faces()) * (sizeof(Vector3) + sizeof(int));
+        bytes += qint64(mesh->n_halfedges()) * (4 * sizeof(int));
+    }
+
+    return bytes;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QSharedPointer>
+
+class Model;
+
+// Least recently used cache of dataset models, bounded by an estimate of their memory use.
+// Pinned models are never evicted, even when the pinned total exceeds the budget.
+// Not thread-safe on its own, Document guards it with its cache lock.
+class ModelCache
+{
+public:
+    ModelCache(qint64 budgetBytes = qint64(2048) << 20);
+
+    QSharedPointer<Model> get(const QString & name);
+    bool contains(const QString & name) const { return entries.contains(name); }
+    void insert(const QString & name, QSharedPointer<Model> model);
+    void remove(const QString & name);
+    void clear();
+
+    // Pins are counted and may be placed before the model is loaded
+    void pin(const QString & name);
+    void unpin(const QString & name);
+    bool isPinned(const QString & name) const { return pins.value(name, 0) > 0; }
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const { return budgetBytes; }
+    qint64 usedBytes() const { return totalBytes; }
+    int count() const { return entries.size(); }
+
+    // Counters
+    quint64 hits, misses, evictions;
+
+    // Meshes and control points of all parts
+    static qint64 estimateSize(Model * model);
+
+protected:
+    struct Entry{
+        QSharedPointer<Model> model;
+        qint64 bytes;
+        quint64 lastUse;
+    };
+    QHash<QString, Entry> entries;
+    QHash<QString, int> pins;
+
+    qint64 budgetBytes, totalBytes;
+    quint64 useClock;
+
+    void evict(const QString & keep = QString());
+};
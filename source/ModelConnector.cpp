@@ -1,31 +1,171 @@
 #include "ModelConnector.h"
-#include "Model.h"
 
-#define PQP_SUPPORT_SURFACEMESH
+#include <QMutex>
+
 #include "PQP/PQPLib.h"
 
-ModelConnector::ModelConnector(Model *g)
+struct ModelConnector::CollisionModel
 {
-    QMap<QString, int> nodeID;
+    PQP::PQP_Model pqp;
+
+    // Distance queries write the closest triangles into the models
+    QMutex lock;
+
+    // Mesh the model was built from
+    opengp::SurfaceMesh::SurfaceMeshModel * mesh = nullptr;
+    int version = -1, numVertices = 0, numFaces = 0;
 
-    PQP::Manager m(g->nodes.size());
+    // Pose of the built geometry, and the pose when the rest geometry was stored
+    PQP::PQP_REAL R[3][3], T[3];
+    PQP::PQP_REAL restR[3][3], restT[3];
+    bool hasRest = false;
+
+    bool isCurrent(opengp::SurfaceMesh::SurfaceMeshModel * m, int meshVersion) const {
+        return mesh == m && version == meshVersion && numVertices == int(m->n_vertices()) && numFaces == int(m->n_faces());
+    }
+};
+
+static QSharedPointer<ModelConnector::CollisionModel> cachedModel(Structure::Node * n)
+{
+    return n->property.value("collisionModel").value< QSharedPointer<ModelConnector::CollisionModel> >();
+}
 
-    // load up meshes for all parts
-    for(auto n : g->nodes)
+QSharedPointer<ModelConnector::CollisionModel> ModelConnector::collisionModel(Model * g, Structure::Node * n)
+{
+    auto mesh = g->getMesh(n->id);
+    if(mesh == nullptr || mesh->n_faces() == 0) return QSharedPointer<CollisionModel>();
+
+    auto cached = cachedModel(n);
+    if(cached && cached->isCurrent(mesh, g->meshVersion(n->id))) return cached;
+
+    auto model = QSharedPointer<CollisionModel>(new CollisionModel());
+    model->mesh = mesh;
+    model->version = g->meshVersion(n->id);
+    model->numVertices = mesh->n_vertices();
+    model->numFaces = mesh->n_faces();
+    PQP::Manager::makeIdentity(model->R, model->T);
+
+    // Only the first three corners of a face are used, as makeModelPQP does
+    auto points = mesh->vertex_coordinates();
+    PQP::PQP_REAL tri[3][3];
+    int fid = 0;
+    model->pqp.BeginModel(mesh->n_faces());
+    for(auto f : mesh->faces())
     {
-        nodeID[n->id] = nodeID.size();
-        auto mesh = makeModelPQP(g->getMesh(n->id));
-        if(mesh.empty()) continue;
+        int corner = 0;
+        for(auto v : mesh->vertices(f))
+        {
+            if(corner == 3) break;
+            for(int i = 0; i < 3; i++) tri[corner][i] = points[v][i];
+            corner++;
+        }
+        model->pqp.AddTri(tri[0], tri[1], tri[2], fid++);
+    }
+    model->pqp.EndModel();
+
+    n->property["collisionModel"].setValue(model);
+    return model;
+}
 
-        m.addModel(mesh);
+void ModelConnector::storeRestPose(Model * g, Structure::Node * n)
+{
+    auto cached = cachedModel(n);
+    if(!cached) return;
+
+    auto mesh = g->getMesh(n->id);
+    cached->hasRest = (mesh != nullptr) && cached->isCurrent(mesh, g->meshVersion(n->id));
+    if(!cached->hasRest) return;
+
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++) cached->restR[i][j] = cached->R[i][j];
+        cached->restT[i] = cached->T[i];
     }
+}
 
-    QMap<QString, QVector<QPair<double, QString> > > possibleEdges;
+void ModelConnector::transformCollisionModel(Model * g, Structure::Node * n, const QMatrix4x4 & transform,
+                                             const Vector3 & centroid, int previousVersion)
+{
+    auto cached = cachedModel(n);
+    auto mesh = g->getMesh(n->id);
+    if(!cached || mesh == nullptr || !cached->hasRest) return;
+    if(!cached->isCurrent(mesh, previousVersion)) return;
+
+    // Scaling can not be expressed by PQP's rotation, the model is rebuilt on next use instead
+    double L[3][3];
+    for(int i = 0; i < 3; i++) for(int j = 0; j < 3; j++) L[i][j] = transform(i, j);
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++){
+            double dot = L[0][i] * L[0][j] + L[1][i] * L[1][j] + L[2][i] * L[2][j];
+            if(std::abs(dot - (i == j ? 1.0 : 0.0)) > 1e-6) return;
+        }
+    }
+
+    // current = L (rest - centroid) + centroid + t, with rest = restR * p + restT
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 3; j++)
+            cached->R[i][j] = L[i][0] * cached->restR[0][j] + L[i][1] * cached->restR[1][j] + L[i][2] * cached->restR[2][j];
+
+        double t = centroid[i] + transform(i, 3);
+        for(int k = 0; k < 3; k++) t += L[i][k] * (cached->restT[k] - centroid[k]);
+        cached->T[i] = t;
+    }
+
+    cached->version = g->meshVersion(n->id);
+}
+
+// Distance between two posed models, zero when they intersect
+static double modelDistance(ModelConnector::CollisionModel & a, ModelConnector::CollisionModel & b)
+{
+    PQP::PQP_Checker checker;
+
+    PQP::PQP_CollideResult collisions;
+    checker.PQP_Collide(&collisions, a.R, a.T, &a.pqp, b.R, b.T, &b.pqp, PQP::PQP_FIRST_CONTACT);
+    if(collisions.num_pairs > 0) return 0;
+
+    PQP::PQP_DistanceResult distance;
+    checker.PQP_Distance(&distance, a.R, a.T, &a.pqp, b.R, b.T, &b.pqp, 1e-12, 1e-12);
+    return distance.Distance();
+}
+
+ModelConnector::ModelConnector(Model *g)
+{
+    double threshold = g->robustBBox().diagonal().norm() * 0.05;
+
+    // Collision models for all parts, reused while meshes are unchanged
+    QVector< QSharedPointer<CollisionModel> > models(g->nodes.size());
+    QVector<Eigen::AlignedBox3d> boxes(g->nodes.size());
 
     for(int i = 0; i < g->nodes.size(); i++)
     {
-        for(int j = i+1; j < g->nodes.size(); j++)
+        models[i] = collisionModel(g, g->nodes[i]);
+        if(!models[i]) continue;
+
+        auto mesh = g->getMesh(g->nodes[i]->id);
+        auto points = mesh->vertex_coordinates();
+        for(auto v : mesh->vertices()) boxes[i].extend(points[v]);
+
+        // Boxes that are closer than the threshold overlap
+        boxes[i].min().array() -= threshold * 0.5;
+        boxes[i].max().array() += threshold * 0.5;
+    }
+
+    // Broad phase: sweep and prune along x
+    QVector<int> order;
+    for(int i = 0; i < g->nodes.size(); i++) if(models[i]) order << i;
+    std::sort(order.begin(), order.end(), [&](int a, int b){ return boxes[a].min().x() < boxes[b].min().x(); });
+
+    QVector< QPair<int,int> > candidates;
+
+    for(int a = 0; a < order.size(); a++)
+    {
+        auto & boxA = boxes[order[a]];
+
+        for(int b = a+1; b < order.size() && boxes[order[b]].min().x() <= boxA.max().x(); b++)
         {
+            if(!boxA.intersects(boxes[order[b]])) continue;
+
+            int i = std::min(order[a], order[b]), j = std::max(order[a], order[b]);
             auto ni = g->nodes[i];
             auto nj = g->nodes[j];
 
@@ -35,17 +175,36 @@ ModelConnector::ModelConnector(Model *g)
             // Ignore when two nodes are in the same group
             if(g->shareGroup(ni->id, nj->id)) continue;
 
-            // Check if edge needs to happen
-            auto isects = m.testIntersection(i,j);
-            std::sort(isects.begin(), isects.end());
-
-            auto closest = isects.front();
-            possibleEdges[ni->id].push_back( qMakePair(closest.distance, nj->id) );
-            possibleEdges[nj->id].push_back( qMakePair(closest.distance, ni->id) );
+            candidates << qMakePair(i, j);
         }
     }
 
-    double threshold = g->robustBBox().diagonal().norm() * 0.05;
+    // Narrow phase on candidates only, each pair holds both model locks taken in node order
+    QVector<double> distances(candidates.size());
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(int c = 0; c < candidates.size(); c++)
+    {
+        auto & mi = *models[candidates[c].first];
+        auto & mj = *models[candidates[c].second];
+
+        QMutexLocker lockFirst(&mi.lock);
+        QMutexLocker lockSecond(&mj.lock);
+
+        // Check if edge needs to happen
+        distances[c] = modelDistance(mi, mj);
+    }
+
+    QMap<QString, QVector<QPair<double, QString> > > possibleEdges;
+
+    for(int c = 0; c < candidates.size(); c++)
+    {
+        auto ni = g->nodes[candidates[c].first];
+        auto nj = g->nodes[candidates[c].second];
+
+        possibleEdges[ni->id].push_back( qMakePair(distances[c], nj->id) );
+        possibleEdges[nj->id].push_back( qMakePair(distances[c], ni->id) );
+    }
 
     for(auto nid : possibleEdges.keys())
     {
@@ -68,4 +227,3 @@ ModelConnector::ModelConnector(Model *g)
 
 	g->ShapeGraph::property["showEdges"].setValue(true);
 }
-
@@ -1,9 +1,23 @@
 #pragma once
 
-class Model;
+#include "Model.h"
 
 class ModelConnector
 {
 public:
     ModelConnector(Model * g);
+
+    // Collision models are kept on the node as "collisionModel" and rebuilt when the node's mesh changes
+    struct CollisionModel;
+
+    // Rigid edits move the cached collision model instead of invalidating it. The transform is relative
+    // to the pose saved by storeRestPose, 'previousVersion' is the mesh version before the edit
+    static void storeRestPose(Model * g, Structure::Node * n);
+    static void transformCollisionModel(Model * g, Structure::Node * n, const QMatrix4x4 & transform,
+                                        const Vector3 & centroid, int previousVersion);
+
+protected:
+    static QSharedPointer<CollisionModel> collisionModel(Model * g, Structure::Node * n);
 };
+
+Q_DECLARE_METATYPE(QSharedPointer<ModelConnector::CollisionModel>)
@@ -0,0 +1,313 @@
+#include "Model.h"
+#include "Viewer.h"
+#include "GeometryHelper.h"
+
+#include <QOpenGLContext>
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+#include <QOffscreenSurface>
+#include <QScopedPointer>
+
+using namespace opengp;
+
+// Drawing is kept apart from the geometry code so that tools without a GL context can build Model.cpp alone
+
+// Interleaved positions and normals of one part, as uploaded for the current shading mode
+struct Model::NodeBuffers{
+    QOpenGLBuffer vbo;
+    QOpenGLVertexArrayObject vao;
+    SurfaceMeshModel * mesh = nullptr;
+    bool isSmoothShading = false;
+    int version = -1;
+    int count = 0;
+};
+
+// Buffers of all parts in one context. GL objects can only be freed with their context current,
+// and models are usually deleted outside of drawing
+struct Model::ContextBuffers{
+    QOpenGLContext * context;
+    QHash< Structure::Node*, QSharedPointer<NodeBuffers> > buffers;
+
+    ContextBuffers(QOpenGLContext * context) : context(context){}
+
+    ~ContextBuffers()
+    {
+        if(buffers.isEmpty()) return;
+
+        auto previousContext = QOpenGLContext::currentContext();
+        auto previousSurface = previousContext ? previousContext->surface() : nullptr;
+
+        QScopedPointer<QOffscreenSurface> surface;
+        if(previousContext != context){
+            surface.reset(new QOffscreenSurface);
+            surface->setFormat(context->format());
+            surface->create();
+            if(!context->makeCurrent(surface.data())) return;
+        }
+
+        for(auto b : buffers){
+            b->vao.destroy();
+            b->vbo.destroy();
+        }
+        buffers.clear();
+
+        if(previousContext != context){
+            context->doneCurrent();
+            if(previousContext) previousContext->makeCurrent(previousSurface);
+        }
+    }
+};
+
+void Model::draw(Viewer *glwidget)
+{
+    // Collect meshes
+    QVector<SurfaceMeshModel *> meshes;
+    for(auto n : nodes){
+        auto mesh = getMesh(n->id);
+        if(mesh != nullptr) { meshes << mesh; } 
+		else
+        {
+            if(n->type() == Structure::CURVE)
+            {
+                // Draw as a basic 3D curve
+                auto nodeColor = n->vis_property["color"].value<QColor>();
+                QVector<QVector3D> lines;
+                auto points = n->controlPoints();
+                for(size_t i = 1; i < points.size(); i++){
+                    lines << QVector3D(points[i-1][0],points[i-1][1],points[i-1][2]);
+                    lines << QVector3D(points[i][0],points[i][1],points[i][2]);
+                }
+                glwidget->glLineWidth(6);
+                glwidget->drawLines(lines, nodeColor, glwidget->pvm, "lines");
+            }
+
+            if(n->type() == Structure::SHEET)
+            {
+                auto & sheet = ((Structure::Sheet*) n)->surface;
+
+                // Build surface geometry if needed
+                if(sheet.quads.empty())
+                {
+                    double resolution = (sheet.mCtrlPoint.front().front()
+                                         - sheet.mCtrlPoint.back().back()).norm() * 0.1;
+                    sheet.generateSurfaceQuads( resolution );
+                }
+
+                // Draw surface as triangles
+                QVector<QVector3D> points, normals;
+                for(auto quad : sheet.quads){
+                    QVector<QVector3D> quad_points, quad_normals;
+
+                    for(int i = 0; i < 4; i++){
+                        quad_points << QVector3D(quad.p[i][0],quad.p[i][1],quad.p[i][2]);
+                        quad_normals << QVector3D(quad.n[i][0],quad.n[i][1],quad.n[i][2]);
+                    }
+
+                    // Add two triangles of the quad
+                    points<<quad_points[0]; normals<<quad_normals[0];
+                    points<<quad_points[1]; normals<<quad_normals[1];
+                    points<<quad_points[2]; normals<<quad_normals[2];
+
+                    points<<quad_points[0]; normals<<quad_normals[0];
+                    points<<quad_points[2]; normals<<quad_normals[2];
+                    points<<quad_points[3]; normals<<quad_normals[3];
+                }
+
+                auto nodeColor = n->vis_property["color"].value<QColor>();
+                glwidget->drawTriangles(nodeColor, points, normals, glwidget->pvm);
+                glwidget->drawPoints(points,nodeColor,glwidget->pvm);
+            }
+        }
+    }
+
+    if(meshes.empty()) return;
+
+    // Draw meshes:
+    glwidget->glEnable(GL_DEPTH_TEST);
+    //glwidget->glEnable(GL_CULL_FACE);
+    glwidget->glCullFace(GL_BACK);
+
+    // Activate shader
+    auto & program = *glwidget->shaders["mesh"];
+    program.bind();
+
+    // Attributes, color is constant per part
+    int vertexLocation = program.attributeLocation("vertex");
+    int normalLocation = program.attributeLocation("normal");
+    int colorLocation = program.attributeLocation("color");
+
+    program.disableAttributeArray(colorLocation);
+
+    // Uniforms
+    int matrixLocation = program.uniformLocation("matrix");
+    int lightPosLocation = program.uniformLocation("lightPos");
+    int viewPosLocation = program.uniformLocation("viewPos");
+    int lightColorLocation = program.uniformLocation("lightColor");
+
+    program.setUniformValue(matrixLocation, glwidget->pvm);
+    program.setUniformValue(lightPosLocation, glwidget->eyePos);
+    program.setUniformValue(viewPosLocation, glwidget->eyePos);
+    program.setUniformValue(lightColorLocation, QVector3D(1,1,1));
+
+    // Add visualized nodes for duplication and such
+    auto allNodes = nodes;
+    for(auto n : tempNodes) allNodes.push_back(n.data());
+
+    auto context = QOpenGLContext::currentContext();
+    auto & contextBuffers = nodeBuffers[context];
+    if(contextBuffers.isNull()){
+        contextBuffers = QSharedPointer<ContextBuffers>(new ContextBuffers(context));
+        connect(context, &QOpenGLContext::aboutToBeDestroyed, this, [=]{ nodeBuffers.remove(context); });
+    }
+    auto & buffers = contextBuffers->buffers;
+
+    auto setAttributeBuffers = [&](){
+        program.enableAttributeArray(vertexLocation);
+        program.enableAttributeArray(normalLocation);
+        program.setAttributeBuffer(vertexLocation, GL_FLOAT, 0, 3, 6 * sizeof(GLfloat));
+        program.setAttributeBuffer(normalLocation, GL_FLOAT, 3 * sizeof(GLfloat), 3, 6 * sizeof(GLfloat));
+    };
+
+    // Draw parts as meshes
+    QSet<Structure::Node*> liveNodes;
+    for(auto n : allNodes)
+    {
+        auto mesh = n->property["mesh"].value< QSharedPointer<SurfaceMeshModel> >().data();
+        if(mesh == nullptr || mesh->n_faces() < 1) continue;
+
+        liveNodes << n;
+        if(n->vis_property["isHidden"].toBool()) continue;
+
+        auto nodeColor = n->vis_property["color"].value<QColor>();
+        bool isSmoothShading = n->vis_property["isSmoothShading"].toBool();
+        int version = meshVersions.value(n->id, 0);
+
+        auto & b = buffers[n];
+        if(b.isNull()) b = QSharedPointer<NodeBuffers>(new NodeBuffers);
+
+        // Upload geometry only when the part changed
+        if(b->mesh != mesh || b->isSmoothShading != isSmoothShading || b->version != version)
+        {
+            QVector<GLfloat> data;
+            data.reserve(mesh->n_faces() * 3 * 6);
+
+            auto mesh_points = mesh->vertex_coordinates();
+            auto mesh_normals = mesh->vertex_normals();
+            auto mesh_fnormals = mesh->face_normals();
+
+            // Pack mesh faces
+            for(auto f : mesh->faces()){
+                for(auto vf : mesh->vertices(f)){
+                    for(int i = 0; i < 3; i++) data << mesh_points[vf][i];
+                    for(int i = 0; i < 3; i++) data << (isSmoothShading ? mesh_normals[vf][i] : mesh_fnormals[f][i]);
+                }
+            }
+
+            if(!b->vbo.isCreated()){
+                b->vbo.create();
+                b->vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
+
+                if(b->vao.create()){
+                    QOpenGLVertexArrayObject::Binder vaoBinder(&b->vao);
+                    b->vbo.bind();
+                    setAttributeBuffers();
+                    b->vbo.release();
+                }
+            }
+
+            b->vbo.bind();
+            b->vbo.allocate(data.constData(), data.size() * sizeof(GLfloat));
+            b->vbo.release();
+
+            b->mesh = mesh;
+            b->isSmoothShading = isSmoothShading;
+            b->version = version;
+            b->count = data.size() / 6;
+        }
+
+        program.setAttributeValue(colorLocation, nodeColor.redF(), nodeColor.greenF(), nodeColor.blueF());
+
+        // Draw
+        if(b->vao.isCreated()){
+            QOpenGLVertexArrayObject::Binder vaoBinder(&b->vao);
+            glwidget->glDrawArrays(GL_TRIANGLES, 0, b->count);
+        } else {
+            b->vbo.bind();
+            setAttributeBuffers();
+            glwidget->glDrawArrays(GL_TRIANGLES, 0, b->count);
+            program.disableAttributeArray(vertexLocation);
+            program.disableAttributeArray(normalLocation);
+            b->vbo.release();
+        }
+    }
+
+    // Release buffers of parts that are gone
+    for(auto it = buffers.begin(); it != buffers.end();){
+        if(liveNodes.contains(it.key())) ++it;
+        else it = buffers.erase(it);
+    }
+
+    program.release();
+
+    // Draw bounding box around active part
+    if(activeNode != nullptr && getMesh(activeNode->id) != nullptr)
+    {
+        auto mesh = getMesh(activeNode->id);
+        auto box = mesh->bbox();
+
+        QVector<Eigen::Vector3d> corners;
+        corners<<box.corner(Eigen::AlignedBox3d::BottomLeftFloor);
+        corners<<box.corner(Eigen::AlignedBox3d::BottomRightFloor);
+        corners<<box.corner(Eigen::AlignedBox3d::TopLeftFloor);
+        corners<<box.corner(Eigen::AlignedBox3d::TopRightFloor);
+        corners<<box.corner(Eigen::AlignedBox3d::BottomLeftCeil);
+        corners<<box.corner(Eigen::AlignedBox3d::BottomRightCeil);
+        corners<<box.corner(Eigen::AlignedBox3d::TopLeftCeil);
+        corners<<box.corner(Eigen::AlignedBox3d::TopRightCeil);
+
+        QVector<QVector3D> lines;
+        auto addLine = [&](Eigen::Vector3d a, Eigen::Vector3d b){
+            Vector3 dir = (a - b).normalized() * 0.025;
+            lines << toQVector3D(a);
+            lines << toQVector3D(a - dir);
+            lines << toQVector3D(b);
+            lines << toQVector3D(b + dir);
+        };
+
+        addLine(corners[0], corners[1]);
+        addLine(corners[0], corners[2]);
+        addLine(corners[0], corners[4]);
+        addLine(corners[1], corners[3]);
+        addLine(corners[1], corners[5]);
+        addLine(corners[2], corners[3]);
+        addLine(corners[2], corners[6]);
+        addLine(corners[3], corners[7]);
+        addLine(corners[4], corners[5]);
+        addLine(corners[4], corners[6]);
+        addLine(corners[5], corners[7]);
+        addLine(corners[6], corners[7]);
+
+        QColor color(255,255,255,150);
+
+        glwidget->glLineWidth(2);
+        glwidget->drawLines(lines, color, glwidget->pvm, "lines");
+    }
+
+    glwidget->glDisable(GL_DEPTH_TEST);
+    //glwidget->glDisable(GL_CULL_FACE);
+
+    if(ShapeGraph::property["showEdges"].toBool())
+    {
+        QVector<QVector3D> lines;
+
+        for(auto e : edges)
+        {
+            lines << toQVector3D(e->position(e->n1->id));
+            lines << toQVector3D(e->position(e->n2->id));
+        }
+
+        glwidget->glLineWidth(4);
+        QColor color(255,0,255,100);
+        glwidget->drawLines(lines, color, glwidget->pvm, "lines");
+    }
+}
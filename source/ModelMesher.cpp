@@ -108,42 +108,29 @@ void ModelMesher::generateOffsetSurface(double offset)
     if (faceList.empty() || vertList.empty()) return;
 
     Array3f phi_grid;
-    SDFGen::make_level_set3(faceList, vertList, min_box, dx, sizes[0], sizes[1], sizes[2], phi_grid, false, offset * 2.0);
+    SDFGen::make_level_set3_parallel(faceList, vertList, min_box, dx, sizes[0], sizes[1], sizes[2], phi_grid, false, offset * 2.0);
 
-    ScalarVolume volume = initScalarVolume(sizes[0], sizes[1], sizes[2], (sizes[0] + sizes[1] + sizes[2])*dx);
-
-    for(size_t i = 0; i < sizes[0]; i++){
-        for(size_t j = 0; j < sizes[1]; j++){
-            for(size_t k = 0; k < sizes[2]; k++){
-                volume[k][j][i] = phi_grid(i,j,k);
-            }
-        }
-    }
-
-    // Mesh surface from volume using marching cubes
-    auto mesh = march(volume, offset);
+    // Mesh surface straight from the distance grid using marching cubes
+    auto mesh = marchIndexed(&phi_grid.a[0], phi_grid.ni, phi_grid.nj, phi_grid.nk, offset);
 
     QSharedPointer<SurfaceMeshModel> newMesh = QSharedPointer<SurfaceMeshModel>(new SurfaceMeshModel());
 
-    int vi = 0;
-    for(auto tri : mesh){
+    // Vertices are already shared between triangles
+    Vector3 origin(min_box[0], min_box[1], min_box[2]);
+    for(auto p : mesh.vertices)
+        newMesh->add_vertex((Vector3(p.x, p.y, p.z) * dx) + origin);
+
+    for(size_t i = 0; i < mesh.triangles.size(); i += 3){
         std::vector<SurfaceMeshModel::Vertex> verts;
-        for(auto p : tri){
-            Vector3 voxel(p.x, p.y, p.z);
-            Vector3 pos = (voxel * dx) + Vector3(min_box[0],min_box[1],min_box[2]);
-            newMesh->add_vertex(pos);
-            verts.push_back(SurfaceMeshModel::Vertex(vi++));
-        }
+        for(int j = 0; j < 3; j++) verts.push_back(SurfaceMeshModel::Vertex(mesh.triangles[i + j]));
         newMesh->add_face(verts);
     }
 
-    GeometryHelper::meregeVertices<Vector3>(newMesh.data());
-
     newMesh->updateBoundingBox();
     newMesh->update_face_normals();
     newMesh->update_vertex_normals();
 
-	n->property["mesh"].setValue(newMesh);
+	m->setNodeMesh(n, newMesh);
 	n->property["mesh_filename"].setValue(QString("meshes/%1.obj").arg(n->id));
 }
 
@@ -156,13 +143,12 @@ void ModelMesher::generateRegularSurface(double offset)
     Structure::Curve* curve = dynamic_cast<Structure::Curve*>(n);
     Structure::Sheet* sheet = dynamic_cast<Structure::Sheet*>(n);
 
-    auto addTriangle = [&](SurfaceMeshModel * newMesh, Vector3 a, Vector3 b, Vector3 c){
-        typedef SurfaceMeshModel::Vertex Vert;
-        int v = newMesh->n_vertices();
-        newMesh->add_vertex(a);
-        newMesh->add_vertex(b);
-        newMesh->add_vertex(c);
-        newMesh->add_triangle(Vert(v + 0), Vert(v + 1), Vert(v + 2));
+    // Triangles are collected as a soup and welded once into the mesh
+    std::vector<Vector3> soup;
+    auto addTriangle = [&](Vector3 a, Vector3 b, Vector3 c){
+        soup.push_back(a);
+        soup.push_back(b);
+        soup.push_back(c);
     };
 
 	QSharedPointer<SurfaceMeshModel> newMesh = QSharedPointer<SurfaceMeshModel>(new SurfaceMeshModel());
@@ -261,8 +247,8 @@ void ModelMesher::generateRegularSurface(double offset)
 				auto c = grid[ip][jp];
 				auto d = grid[i][jp];
 
-                if (i != 0) addTriangle(newMesh.data(), a, b, d);
-                if (i != grid.size() - 2) addTriangle(newMesh.data(), b, c, d);
+                if (i != 0) addTriangle(a, b, d);
+                if (i != grid.size() - 2) addTriangle(b, c, d);
 			}
 		}
     }
@@ -290,20 +276,20 @@ void ModelMesher::generateRegularSurface(double offset)
                 corn << bbox.corner(Eigen::AlignedBox3d::CornerType(Eigen::AlignedBox3d::CornerType::BottomLeftFloor + i));
             }
 
-            addTriangle(newMesh.data(), corn[0], corn[1], corn[2]);
-            addTriangle(newMesh.data(), corn[1], corn[3], corn[2]);
-            addTriangle(newMesh.data(), corn[6], corn[5], corn[4]);
-            addTriangle(newMesh.data(), corn[6], corn[7], corn[5]);
+            addTriangle(corn[0], corn[1], corn[2]);
+            addTriangle(corn[1], corn[3], corn[2]);
+            addTriangle(corn[6], corn[5], corn[4]);
+            addTriangle(corn[6], corn[7], corn[5]);
 
-            addTriangle(newMesh.data(), corn[1], corn[0], corn[4]);
-            addTriangle(newMesh.data(), corn[1], corn[4], corn[5]);
-            addTriangle(newMesh.data(), corn[2], corn[3], corn[7]);
-            addTriangle(newMesh.data(), corn[2], corn[7], corn[6]);
+            addTriangle(corn[1], corn[0], corn[4]);
+            addTriangle(corn[1], corn[4], corn[5]);
+            addTriangle(corn[2], corn[3], corn[7]);
+            addTriangle(corn[2], corn[7], corn[6]);
 
-            addTriangle(newMesh.data(), corn[3], corn[1], corn[5]);
-            addTriangle(newMesh.data(), corn[3], corn[5], corn[7]);
-            addTriangle(newMesh.data(), corn[0], corn[2], corn[4]);
-            addTriangle(newMesh.data(), corn[4], corn[2], corn[6]);
+            addTriangle(corn[3], corn[1], corn[5]);
+            addTriangle(corn[3], corn[5], corn[7]);
+            addTriangle(corn[0], corn[2], corn[4]);
+            addTriangle(corn[4], corn[2], corn[6]);
         }
         else
         {
@@ -312,13 +298,13 @@ void ModelMesher::generateRegularSurface(double offset)
         }
     }
 
-    GeometryHelper::meregeVertices<Vector3>(newMesh.data());
+    GeometryHelper::addWeldedTriangles(newMesh.data(), soup, offset * 1e-6);
 
 	newMesh->updateBoundingBox();
 	newMesh->update_face_normals();
 	newMesh->update_vertex_normals();
 
-	n->property["mesh"].setValue(newMesh);
+	m->setNodeMesh(n, newMesh);
 	n->property["mesh_filename"].setValue(QString("meshes/%1.obj").arg(n->id));
 }
 
@@ -0,0 +1,132 @@
+#include "OffscreenRenderer.h"
+#include "Viewer.h"
+
+#include <QTimer>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOffscreenSurface>
+
+OffscreenRenderer * OffscreenRenderer::of(Viewer * viewer)
+{
+    auto renderer = viewer->findChild<OffscreenRenderer*>(QString(), Qt::FindDirectChildrenOnly);
+    if(!renderer) renderer = new OffscreenRenderer(viewer);
+    return renderer;
+}
+
+OffscreenRenderer::OffscreenRenderer(Viewer * viewer) : QObject(viewer), viewer(viewer), context(nullptr), surface(nullptr)
+{
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+    if(context && surface && context->makeCurrent(surface))
+    {
+        qDeleteAll(pool);
+        context->doneCurrent();
+    }
+
+    delete context;
+    delete surface;
+}
+
+bool OffscreenRenderer::makeCurrent()
+{
+    if(!context)
+    {
+        context = new QOpenGLContext();
+        context->setShareContext(viewer->context());
+        context->setFormat(viewer->format());
+        context->create();
+
+        surface = new QOffscreenSurface();
+        surface->setFormat(context->format());
+        surface->create();
+    }
+
+    return context->makeCurrent(surface);
+}
+
+QOpenGLFramebufferObject * OffscreenRenderer::framebuffer(QSize size)
+{
+    auto key = qMakePair(size.width(), size.height());
+    if(!pool.contains(key))
+    {
+        QOpenGLFramebufferObjectFormat fboformat;
+        fboformat.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+        pool[key] = new QOpenGLFramebufferObject(size, fboformat);
+    }
+    return pool[key];
+}
+
+QImage OffscreenRenderer::draw(QSize size, const QVector<Thumbnail::QBasicMesh> & meshes, QMatrix4x4 pvm)
+{
+    auto renderFbo = framebuffer(size);
+    renderFbo->bind();
+
+    viewer->glEnable(GL_DEPTH_TEST);
+    viewer->glEnable(GL_BLEND);
+    viewer->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    viewer->glCullFace(GL_BACK);
+
+    viewer->glClearColor(0,0,0,0);
+    viewer->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    viewer->glViewport(0, 0, size.width(), size.height());
+
+    for (auto & mesh : meshes)
+    {
+        if (mesh.isPoints)
+            viewer->drawOrientedPoints(mesh.points, mesh.normals, mesh.color, pvm);
+        else
+            viewer->drawTriangles(mesh.color, mesh.points, mesh.normals, pvm);
+    }
+
+    viewer->glDisable(GL_DEPTH_TEST);
+    viewer->glFlush();
+
+    renderFbo->release();
+    return renderFbo->toImage();
+}
+
+QImage OffscreenRenderer::render(QSize size, const QVector<Thumbnail::QBasicMesh> & meshes, QMatrix4x4 pvm)
+{
+    QImage image;
+    if(makeCurrent()) image = draw(size, meshes, pvm);
+
+    // Thanks for sharing!
+    viewer->makeCurrent();
+    return image;
+}
+
+void OffscreenRenderer::enqueue(QObject * owner, QSize size, const QVector<Thumbnail::QBasicMesh> & meshes,
+                                QMatrix4x4 pvm, std::function<void(QImage)> done)
+{
+    // First request of a batch schedules it, the rest of this paint joins it
+    if(pending.isEmpty()) QTimer::singleShot(0, this, SLOT(flush()));
+
+    Request r;
+    r.owner = owner;
+    r.size = size;
+    r.meshes = meshes;
+    r.pvm = pvm;
+    r.done = done;
+    pending << r;
+}
+
+void OffscreenRenderer::flush()
+{
+    auto batch = pending;
+    pending.clear();
+    if(batch.isEmpty()) return;
+
+    QVector<QImage> images(batch.size());
+    if(makeCurrent())
+    {
+        for(int i = 0; i < batch.size(); i++)
+            if(batch[i].owner) images[i] = draw(batch[i].size, batch[i].meshes, batch[i].pvm);
+    }
+    viewer->makeCurrent();
+
+    // Callbacks may repaint and queue again, they run once the batch is done
+    for(int i = 0; i < batch.size(); i++)
+        if(batch[i].owner) batch[i].done(images[i]);
+}
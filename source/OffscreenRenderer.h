@@ -0,0 +1,56 @@
+#pragma once
+#include <QObject>
+#include <QPointer>
+#include <QImage>
+#include <QMap>
+#include <functional>
+
+#include "Thumbnail.h"
+
+class Viewer;
+class QOpenGLContext;
+class QOffscreenSurface;
+class QOpenGLFramebufferObject;
+
+// One offscreen context per viewer, shared with it, and a pool of framebuffers reused across renders.
+// Requests queued while the scene paints are rendered together on the next event loop pass
+class OffscreenRenderer : public QObject
+{
+    Q_OBJECT
+public:
+    static OffscreenRenderer * of(Viewer * viewer);
+    ~OffscreenRenderer();
+
+    // Renders right away, the viewer's context is current again afterwards
+    QImage render(QSize size, const QVector<Thumbnail::QBasicMesh> & meshes, QMatrix4x4 pvm);
+
+    // Renders with the next batch, 'done' is skipped once 'owner' is gone
+    void enqueue(QObject * owner, QSize size, const QVector<Thumbnail::QBasicMesh> & meshes, QMatrix4x4 pvm,
+                 std::function<void(QImage)> done);
+
+public slots:
+    void flush();
+
+protected:
+    OffscreenRenderer(Viewer * viewer);
+
+    Viewer * viewer;
+    QOpenGLContext * context;
+    QOffscreenSurface * surface;
+
+    // One framebuffer per size, most thumbnails share the same few sizes
+    QMap< QPair<int,int>, QOpenGLFramebufferObject* > pool;
+    QOpenGLFramebufferObject * framebuffer(QSize size);
+
+    bool makeCurrent();
+    QImage draw(QSize size, const QVector<Thumbnail::QBasicMesh> & meshes, QMatrix4x4 pvm);
+
+    struct Request{
+        QPointer<QObject> owner;
+        QSize size;
+        QVector<Thumbnail::QBasicMesh> meshes;
+        QMatrix4x4 pvm;
+        std::function<void(QImage)> done;
+    };
+    QVector<Request> pending;
+};
@@ -0,0 +1,136 @@
+#include "PairwiseCache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDirIterator>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QStringList>
+#include <QCryptographicHash>
+
+// Version of the entry layout, entries of other versions are recomputed
+static const quint32 entryMagic = 0x54425043;
+static const quint32 entryVersion = 2;
+
+typedef QVector< QPair<QString, QString> > MatchingPairs;
+
+PairwiseCache::PairwiseCache(QString folder, const QVariantMap & searchOptions) : folder(folder), optionsKey(optionsHash(searchOptions))
+{
+
+}
+
+bool PairwiseCache::exists() const
+{
+    return QDir(folder).exists();
+}
+
+QString PairwiseCache::entryFile(QString sourceHash, QString targetHash) const
+{
+    return folder + "/" + sourceHash + "_" + targetHash + "_" + optionsKey + ".dat";
+}
+
+bool PairwiseCache::load(QString sourceHash, QString targetHash, QVariantMap & result) const
+{
+    QFile file(entryFile(sourceHash, targetHash));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0, version = 0;
+    QVariantMap entry;
+    in >> magic >> version;
+    if (magic != entryMagic || version != entryVersion) return false;
+    in >> entry;
+
+    // Entries are written in one go, anything unreadable or without a cost is a broken file
+    if (in.status() != QDataStream::Ok || !entry.contains("min_cost")) return false;
+
+    // Pairs are stored as "source,target" strings
+    MatchingPairs matching_pairs;
+    for (auto txtPair : entry["matching_pairs"].toStringList()){
+        auto p = txtPair.split(",", QString::SkipEmptyParts);
+        if (p.size() != 2) continue;
+        matching_pairs << qMakePair(p.front(), p.back());
+    }
+    entry["matching_pairs"].setValue(matching_pairs);
+
+    result = entry;
+    return true;
+}
+
+bool PairwiseCache::store(QString sourceHash, QString targetHash, const QVariantMap & result)
+{
+    if (!QDir().mkpath(folder)) return false;
+
+    QVariantMap entry;
+    for (auto key : result.keys())
+    {
+        auto value = result[key];
+
+        if (key == "matching_pairs"){
+            QStringList matches;
+            for (auto p : value.value<MatchingPairs>())
+                matches << QString("%1,%2").arg(p.first).arg(p.second);
+            entry[key] = matches;
+        }
+        else if (value.userType() < QMetaType::User){
+            entry[key] = value;
+        }
+    }
+
+    // Write to a temporary file first so a crash never leaves a half written entry
+    QSaveFile file(entryFile(sourceHash, targetHash));
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << entryMagic << entryVersion << entry;
+    if (out.status() != QDataStream::Ok) return false;
+
+    return file.commit();
+}
+
+QString PairwiseCache::optionsHash(const QVariantMap & searchOptions)
+{
+    // Keys come sorted out of the map, so equal options always give the same hash
+    QStringList items;
+    for (auto key : searchOptions.keys())
+        items << key + "=" + searchOptions[key].toString();
+
+    auto hash = QCryptographicHash::hash(items.join(";").toUtf8(), QCryptographicHash::Sha1);
+    return QString(hash.toHex()).left(12);
+}
+
+QString PairwiseCache::contentHash(QString graphFile)
+{
+    QFileInfo graphInfo(graphFile);
+    if (!graphInfo.exists()) return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    // Graph description
+    {
+        QFile file(graphFile);
+        if (!file.open(QIODevice::ReadOnly)) return QString();
+        hash.addData(&file);
+    }
+
+    // Meshes referenced by the graph live in the same folder
+    QDir shapeDir = graphInfo.dir();
+    QStringList meshFiles;
+    QDirIterator it(shapeDir.absolutePath(), QStringList() << "*.obj", QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) meshFiles << shapeDir.relativeFilePath(it.next());
+    meshFiles.sort();
+
+    for (auto meshFile : meshFiles)
+    {
+        QFile file(shapeDir.absoluteFilePath(meshFile));
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        hash.addData(meshFile.toUtf8());
+        hash.addData(&file);
+    }
+
+    return QString(hash.result().toHex());
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QString>
+#include <QVariantMap>
+
+// Persistent store of pairwise matching results, one small file per ordered pair of shapes.
+// Entries are keyed by content hashes of both shapes and by the search options, so a shape
+// that changes on disk or a search run with other settings simply misses the cache.
+// The whole report of the best job is kept, except values of types that can not be streamed.
+class PairwiseCache
+{
+public:
+    PairwiseCache(QString folder, const QVariantMap & searchOptions = QVariantMap());
+
+    bool exists() const;
+
+    bool load(QString sourceHash, QString targetHash, QVariantMap & result) const;
+    bool store(QString sourceHash, QString targetHash, const QVariantMap & result);
+
+    // Hash of a shape graph file and every mesh stored next to it
+    static QString contentHash(QString graphFile);
+
+    // Hash of the options a search ran with
+    static QString optionsHash(const QVariantMap & searchOptions);
+
+protected:
+    QString folder, optionsKey;
+    QString entryFile(QString sourceHash, QString targetHash) const;
+};
@@ -4,12 +4,10 @@
 
 #include "GraphicsView.h"
 #include "Viewer.h"
+#include "OffscreenRenderer.h"
+#include "ThumbnailCache.h"
 
-#include <QOpenGLFramebufferObject>
-#include <QOffscreenSurface>
-#include <QOpenGLFunctions>
-
-Thumbnail::Thumbnail(QGraphicsItem *parent, QRectF rect) : QGraphicsObject(parent), rect(rect)
+Thumbnail::Thumbnail(QGraphicsItem *parent, QRectF rect) : QGraphicsObject(parent), rect(rect), isRenderQueued(false)
 {
 	//setFlags( QGraphicsItem::ItemIsMovable );
 	setFlags(QGraphicsItem::ItemIsFocusable);
@@ -46,48 +44,22 @@ void Thumbnail::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidg
         if (img.isNull() || isTempImage)
 		{
 			auto glwidget = (Viewer*)widget;
-			if (glwidget)
+			if (glwidget && !isRenderQueued)
 			{
-				QOpenGLContext context;
-				context.setShareContext(glwidget->context());
-				context.setFormat(glwidget->format());
-				context.create();
-
-				QOffscreenSurface m_offscreenSurface;
-				m_offscreenSurface.setFormat(context.format());
-				m_offscreenSurface.create();
-
-				context.makeCurrent(&m_offscreenSurface);
-
-				QOpenGLFramebufferObjectFormat fboformat;
-				fboformat.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
-				QOpenGLFramebufferObject renderFbo(rect.width() * 2, rect.height() * 2, fboformat);
-				renderFbo.bind();
-
-				glwidget->glEnable(GL_DEPTH_TEST);
-				glwidget->glEnable(GL_BLEND);
-				glwidget->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-				glwidget->glCullFace(GL_BACK);
-
-				glwidget->glClearColor(0,0,0,0);
-				glwidget->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-				glwidget->glViewport(0, 0, renderFbo.size().width(), renderFbo.size().height());
-				
-                if(mesh.points.size())
-                    glwidget->drawTriangles(mesh.color, mesh.points, mesh.normals, pvm);
-
-				// Draw aux meshes
-				for (auto auxmesh : auxMeshes)
-					glwidget->drawTriangles(auxmesh.color, auxmesh.points, auxmesh.normals, pvm);
-				
-				glwidget->glDisable(GL_DEPTH_TEST);
-				glwidget->glFlush();
-
-				renderFbo.release();
-                this->setImage( renderFbo.toImage().scaledToWidth(rect.width(), Qt::SmoothTransformation) );
-
-				// Thanks for sharing!
-				glwidget->makeCurrent();
+				QVector<QBasicMesh> meshes;
+				if (mesh.points.size()) meshes << mesh;
+				meshes << auxMeshes;
+
+				// Rendered with the rest of the thumbnails painted now, shown on the next paint
+				isRenderQueued = true;
+				auto size = QSize(rect.width() * 2, rect.height() * 2);
+				OffscreenRenderer::of(glwidget)->enqueue(this, size, meshes, pvm, [this](QImage image){
+					isRenderQueued = false;
+					if (image.isNull()) return;
+					this->setImage(image.scaledToWidth(rect.width(), Qt::SmoothTransformation));
+					ThumbnailCache::store(cacheFile, img);
+					update();
+				});
 			}
 
 			/*painter->beginNativePainting();
@@ -137,6 +109,16 @@ void Thumbnail::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidg
     postPaint(painter, widget);
 }
 
+bool Thumbnail::setCacheFile(QString filename, QImage cached)
+{
+    cacheFile = filename;
+
+    if (cached.isNull() && !ThumbnailCache::load(filename, cached)) return false;
+
+    setImage(cached);
+    return true;
+}
+
 void Thumbnail::prePaint(QPainter *painter, QWidget *)
 {
     bool isFlatBackground = false;
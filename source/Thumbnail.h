@@ -3,6 +3,8 @@
 #include <QVector3D>
 #include <QMatrix4x4>
 
+#include "BasicMesh.h"
+
 class Thumbnail : public QGraphicsObject
 {
     Q_OBJECT
@@ -19,16 +21,7 @@ public:
     void prePaint(QPainter * painter, QWidget * widget);
     void postPaint(QPainter * painter, QWidget * widget);
 
-    struct QBasicMesh{
-		QVector<QVector3D> points, normals; QColor color;
-		void addTri(QVector3D v0, QVector3D v1, QVector3D v2,
-			QVector3D n0, QVector3D n1, QVector3D n2){
-			points << v0 << v1 << v2;
-			normals << n0 << n1 << n2;
-		}
-        bool isPoints;
-        QBasicMesh() : isPoints(false){}
-	};
+    typedef ::QBasicMesh QBasicMesh;
 
     QVariantMap data;
 
@@ -47,6 +40,10 @@ public:
 
     void setData(QVariantMap fromData){ data = fromData; }
 
+    // Rendered images are saved to 'filename', returns true when an image saved earlier was loaded.
+    // An image already read from the file can be passed in as 'cached'
+    bool setCacheFile(QString filename, QImage cached = QImage());
+
 	void addAuxMesh(QBasicMesh auxMesh){ auxMeshes << auxMesh; }
 
     void saveImage(QString filename);
@@ -56,6 +53,8 @@ public:
 public:
     static QBasicMesh buildTetrahedron(float length);
 
+    static QBasicMesh toBasicMesh(opengp::SurfaceMesh::SurfaceMeshModel * m, QColor color){ return ::toBasicMesh(m, color); }
+
 protected:
     QImage img;
     QString caption;
@@ -63,6 +62,8 @@ protected:
 	QImage meshImage;
 	QVector<QBasicMesh> auxMeshes;
     bool isTempImage;
+    bool isRenderQueued;
+    QString cacheFile;
 
     void mousePressEvent(QGraphicsSceneMouseEvent *);
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *);
@@ -0,0 +1,47 @@
+#include "ThumbnailCache.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QCryptographicHash>
+
+ThumbnailCache::ThumbnailCache(QString folder) : folder(folder)
+{
+
+}
+
+QString ThumbnailCache::entryFile(QString shapeHash, const QMatrix4x4 & camera, QSize size) const
+{
+    if (shapeHash.isEmpty()) return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(shapeHash.toUtf8());
+    hash.addData((const char*)camera.constData(), 16 * sizeof(float));
+    hash.addData(QString("%1x%2").arg(size.width()).arg(size.height()).toUtf8());
+
+    return folder + "/" + QString(hash.result().toHex()) + ".png";
+}
+
+bool ThumbnailCache::load(QString filename, QImage & image)
+{
+    if (filename.isEmpty() || !QFileInfo(filename).exists()) return false;
+
+    QImage cached;
+    if (!cached.load(filename, "PNG")) return false;
+
+    image = cached;
+    return true;
+}
+
+bool ThumbnailCache::store(QString filename, const QImage & image)
+{
+    if (filename.isEmpty() || image.isNull()) return false;
+    if (!QDir().mkpath(QFileInfo(filename).absolutePath())) return false;
+
+    // Write to a temporary file first so a crash never leaves a half written image
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    if (!image.save(&file, "PNG")) return false;
+
+    return file.commit();
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <QString>
+#include <QImage>
+#include <QMatrix4x4>
+
+// Persistent store of rendered thumbnails, one image per shape, camera and resolution.
+// Entries are keyed by the content hash of the shape, so an edited shape misses the
+// cache and gets rendered again.
+class ThumbnailCache
+{
+public:
+    ThumbnailCache(QString folder);
+
+    // Empty when the shape has no content hash
+    QString entryFile(QString shapeHash, const QMatrix4x4 & camera, QSize size) const;
+
+    static bool load(QString filename, QImage & image);
+    static bool store(QString filename, const QImage & image);
+
+protected:
+    QString folder;
+};
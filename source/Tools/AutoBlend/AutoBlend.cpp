@@ -7,38 +7,15 @@
 #include "GraphicsScene.h"
 #include "GraphicsView.h"
 #include "Gallery.h"
+#include "GalleryLoader.h"
 #include "Thumbnail.h"
+#include "BlendJob.h"
 
-#include <QMainWindow>
-#include <QMessageBox>
 #include <QGraphicsDropShadowEffect>
 #include <QTimer>
+#include <QtConcurrent>
 
-#include "GraphCorresponder.h"
-#include "TopoBlender.h"
-#include "Scheduler.h"
-#include "SynthesisManager.h"
-
-#include "ResolveCorrespondence.h"
-
-auto toBasicMesh = [](opengp::SurfaceMesh::SurfaceMeshModel * m, QColor color){
-	Thumbnail::QBasicMesh mesh;
-	m->update_face_normals();
-	for (auto f : m->faces()){
-		QVector<QVector3D> fp, fn;
-		for (auto vf : m->vertices(f)){
-			auto p = m->vertex_coordinates()[vf];
-			auto n = m->face_normals()[f];
-			fp << QVector3D(p[0], p[1], p[2]);
-			fn << QVector3D(n[0], n[1], n[2]);
-		}
-		mesh.addTri(fp[0], fp[1], fp[2], fn[0], fn[1], fn[2]);
-	}
-	mesh.color = color;
-	return mesh;
-};
-
-AutoBlend::AutoBlend(Document *document, const QRectF &bounds) : Tool(document), gallery(nullptr), results(nullptr)
+AutoBlend::AutoBlend(Document *document, const QRectF &bounds) : Tool(document), widget(nullptr), gallery(nullptr), results(nullptr), galleryLoader(nullptr), numBlending(0)
 {
     // Enable keyboard
     this->setFlags(QGraphicsItem::ItemIsFocusable);
@@ -47,6 +24,12 @@ AutoBlend::AutoBlend(Document *document, const QRectF &bounds) : Tool(document),
     setObjectName("autoBlend");
 }
 
+AutoBlend::~AutoBlend()
+{
+    for(auto job : blendJobs) job->cancel();
+    blendPool.waitForDone();
+}
+
 void AutoBlend::init()
 {
     // Add widget
@@ -135,33 +118,19 @@ void AutoBlend::init()
 			// Fill gallery
 			gallery->clearThumbnails();
 
-			auto catModels = document->categories[document->currentCategory].toStringList();
-			for (auto targetName : catModels)
-			{
-				auto targetModel = document->cacheModel(targetName);
-				auto t = gallery->addTextItem(targetName);
-
-				QVariantMap data = t->data;
-				data["targetName"].setValue(targetName);
-				t->setData(data);
-
-				t->setCamera(cameraPos, cameraMatrix);
-				t->setFlag(QGraphicsItem::ItemIsSelectable);
-
-				// Add parts of target shape
-				for (auto n : targetModel->nodes){
-					t->addAuxMesh(toBasicMesh(targetModel->getMesh(n->id), n->vis_property["color"].value<QColor>()));
-				}
-
-                scene()->update(t->sceneBoundingRect());
-            }
+			// Shapes are loaded and converted in the background, thumbnails fill in as they are ready
+			if (galleryLoader) galleryLoader->discard();
+			galleryLoader = new GalleryLoader(document, gallery, cameraPos, cameraMatrix, this);
+			galleryLoader->load(document->categories[document->currentCategory].toStringList());
 
             scene()->update(this->sceneBoundingRect());
             QTimer::singleShot(500, [=]{ gallery->update(); });
 		});
 
 		// Do blend
-		connect(widget->blendButton, SIGNAL(pressed()), SLOT(doBlend())); 
+		connect(widget->blendButton, SIGNAL(pressed()), SLOT(doBlend()));
+		connect(widget->cancelButton, SIGNAL(pressed()), SLOT(cancelBlend()));
+		widget->cancelButton->setEnabled(false);
     }
 }
 
@@ -187,113 +156,66 @@ void AutoBlend::doBlend()
 	auto selected = gallery->getSelected();
 	if (selected.size() < 2) return;
 
+    cancelBlend();
+
     for(auto t : results->items) t->deleteLater();
     results->items.clear();
 
-    ((GraphicsScene*)scene())->showPopup("Please wait..");
+    int numResults = widget->count->value();
+    int LOD = widget->levelDetails->currentIndex();
 
     for(int shapeI = 0; shapeI < selected.size(); shapeI++)
     {
         for(int shapeJ = shapeI + 1; shapeJ < selected.size(); shapeJ++)
         {
-            //auto sourceName = selected.front()->data["targetName"].toString();
-            //auto targetName = selected.back()->data["targetName"].toString();
-
             auto sourceName = selected[shapeI]->data.value("targetName").toString();
             auto targetName = selected[shapeJ]->data.value("targetName").toString();
 
-            auto cacheSource = document->cacheModel(sourceName);
-            auto cacheTarget = document->cacheModel(targetName);
-
-            if(cacheSource == nullptr || cacheTarget == nullptr) continue;
-
-            auto source = QSharedPointer<Structure::Graph>(cacheSource->cloneAsShapeGraph());
-			auto target = QSharedPointer<Structure::Graph>(cacheTarget->cloneAsShapeGraph());
-
-			auto gcorr = QSharedPointer<GraphCorresponder>(new GraphCorresponder(source.data(), target.data()));
-
-			// Apply computed correspondence
-            //if (false) // enable/disable auto correspondence
-			{
-                QVector<QPair<QString, QString> > all_pairs;
-
-                for(auto n : source->nodes)
-                {
-                    if (!document->datasetCorr[sourceName][n->id][targetName].empty())
-                    {
-                        for(auto nj : document->datasetCorr[sourceName][n->id][targetName])
-                        {
-                            all_pairs << qMakePair(n->id, nj);
-                        }
-                    }
-                }
-
-                ResolveCorrespondence(source.data(), target.data(), all_pairs, gcorr.data());
-			}
-
-            gcorr->computeCorrespondences();
-
-            // Schedule blending sequence
-            auto scheduler = QSharedPointer<Scheduler>(new Scheduler);
-            auto blender = QSharedPointer<TopoBlender>(new TopoBlender(gcorr.data(), scheduler.data()));
-
-            // Sample geometries
-            int numSamples = 100;
-            int reconLevel = 4;
-
-            int LOD = widget->levelDetails->currentIndex();
-            switch (LOD){
-                case 0: numSamples = 100; reconLevel = 4; break;
-                case 1: numSamples = 1000; reconLevel = 5; break;
-                case 2: numSamples = 10000; reconLevel = 7; break;
-            }
+            // Released on the GUI thread once both the worker and this tool are done with it
+            auto job = QSharedPointer<BlendJob>(new BlendJob(document, sourceName, targetName, numResults, LOD), &QObject::deleteLater);
 
-            /// Visualize schedule:
-            if (false)
-            {
-                blender->parentWidget = new QMainWindow();
-                blender->parentWidget->show();
-                blender->setupUI();
-
-                QStringList corr;
-                for(auto n : scheduler->activeGraph->nodes){
-                    corr << QString("%1-%2").arg(n->id, n->property["correspond"].toString());
-                }
-
-                QMessageBox::information(blender->parentWidget, "Correspondence", corr.join("\n"));
-            }
+            connect(job.data(), &BlendJob::resultReady, this, [=](QString name, QVector<Thumbnail::QBasicMesh> parts){
+                auto t = results->addTextItem("");
+                t->setCamera(cameraPos, cameraMatrix);
 
-            auto synthManager = QSharedPointer<SynthesisManager>(new SynthesisManager(gcorr.data(), scheduler.data(), blender.data(), numSamples));
-            synthManager->genSynData();
+                QVariantMap data;
+                data["name"] = name;
+                t->setData(data);
 
-            // Compute blending
-            scheduler->timeStep = 1.0 / 100.0;
-            scheduler->defaultSchedule();
-            scheduler->executeAll();
+                for (auto & part : parts) t->addAuxMesh(part);
 
-            int numResults = widget->count->value();
+                t->update();
+            });
 
-            for (int i = 0; i < numResults; i++)
-            {
-                double a = ((double(i) / (numResults - 1)) * 0.9) + 0.05;
-                auto blendedModel = scheduler->allGraphs[a * (scheduler->allGraphs.size() - 1)];
+            connect(job.data(), &BlendJob::finished, this, [=](){
+                if (--numBlending > 0) return;
+                blendJobs.clear();
+                widget->cancelButton->setEnabled(false);
+                ((GraphicsScene*)scene())->hidePopup();
+            });
 
-                synthManager->renderGraph(*blendedModel, "", false, reconLevel );
+            blendJobs << job;
+            numBlending++;
 
-                auto t = results->addTextItem("");
-                t->setCamera(cameraPos, cameraMatrix);
+            QtConcurrent::run(&blendPool, [job](){ job->run(); });
+        }
+    }
 
-                QVariantMap data;
-                data["name"] = QString("%1_%2").arg(sourceName).arg(targetName);
-                t->setData(data);
+    widget->cancelButton->setEnabled(true);
+    ((GraphicsScene*)scene())->showPopup("Please wait..");
+}
 
-                // Add parts of target shape
-                for (auto n : blendedModel->nodes){
-                    t->addAuxMesh(toBasicMesh(blendedModel->getMesh(n->id), n->vis_property["color"].value<QColor>()));
-                }
-            }
-        }
+void AutoBlend::cancelBlend()
+{
+    // Running jobs stop at their next step, their remaining results are dropped
+    for(auto job : blendJobs)
+    {
+        job->cancel();
+        job->disconnect(this);
     }
+    blendJobs.clear();
+    numBlending = 0;
 
-    ((GraphicsScene*)scene())->hidePopup();
+    if (widget) widget->cancelButton->setEnabled(false);
+    if (scene()) ((GraphicsScene*)scene())->hidePopup();
 }
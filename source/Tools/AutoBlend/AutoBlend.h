@@ -1,15 +1,20 @@
 #pragma once
 #include "Tool.h"
 #include <QMatrix4x4>
+#include <QThreadPool>
+#include <QSharedPointer>
 
 namespace Ui{ class AutoBlendWidget; }
 class Gallery;
+class GalleryLoader;
+class BlendJob;
 
 class AutoBlend : public Tool
 {
     Q_OBJECT
 public:
     AutoBlend(Document * document, const QRectF &bounds);
+    ~AutoBlend();
     void init();
 
 protected:
@@ -18,13 +23,20 @@ protected:
 
     Gallery * gallery;
     Gallery * results;
+    GalleryLoader * galleryLoader;
 
 	QMatrix4x4 cameraMatrix;
 	QVector3D cameraPos;
 
+    // Selected pairs blend concurrently, results are added as they come in
+    QThreadPool blendPool;
+    QVector< QSharedPointer<BlendJob> > blendJobs;
+    int numBlending;
+
 protected:
     void keyPressEvent(QKeyEvent *event);
 
 public slots:
 	void doBlend();
+    void cancelBlend();
 };
@@ -0,0 +1,136 @@
+#include "BlendJob.h"
+
+#include "Document.h"
+#include "Model.h"
+
+#include "GraphCorresponder.h"
+#include "TopoBlender.h"
+#include "Scheduler.h"
+#include "SynthesisManager.h"
+
+#include "ResolveCorrespondence.h"
+
+BlendJob::BlendJob(Document * document, QString sourceName, QString targetName, int numResults, int LOD) :
+    document(document), sourceName(sourceName), targetName(targetName), numResults(numResults), LOD(LOD), isDone(false)
+{
+}
+
+void BlendJob::post(const Result & result, bool isLast)
+{
+    {
+        QMutexLocker locker(&readyLock);
+        if(!result.parts.isEmpty()) ready << result;
+        if(isLast) isDone = true;
+    }
+
+    QMetaObject::invokeMethod(this, "deliver", Qt::QueuedConnection);
+}
+
+void BlendJob::deliver()
+{
+    QVector<Result> results;
+    bool isFinished;
+    {
+        QMutexLocker locker(&readyLock);
+        results.swap(ready);
+        isFinished = isDone;
+        isDone = false;
+    }
+
+    if(!isCancelled.load())
+        for(auto & r : results) emit(resultReady(r.name, r.parts));
+
+    if(isFinished) emit(finished());
+}
+
+void BlendJob::run()
+{
+    if(isCancelled.load()){ post(Result(), true); return; }
+
+    // Models stay resident while they are cloned
+    document->pinModel(sourceName);
+    document->pinModel(targetName);
+
+    auto cacheSource = document->cacheModel(sourceName);
+    auto cacheTarget = document->cacheModel(targetName);
+
+    QSharedPointer<Structure::Graph> source, target;
+    if(cacheSource && cacheTarget)
+    {
+        source = QSharedPointer<Structure::Graph>(cacheSource->cloneAsShapeGraph());
+        target = QSharedPointer<Structure::Graph>(cacheTarget->cloneAsShapeGraph());
+    }
+
+    document->unpinModel(sourceName);
+    document->unpinModel(targetName);
+
+    if(!source || !target){ post(Result(), true); return; }
+
+    auto gcorr = QSharedPointer<GraphCorresponder>(new GraphCorresponder(source.data(), target.data()));
+
+    // Apply computed correspondence
+    {
+        QVector<QPair<QString, QString> > all_pairs;
+
+        auto index = document->corrIndex();
+        int s = index->shapeID(sourceName), t = index->shapeID(targetName);
+
+        for(auto n : source->nodes)
+        {
+            for(auto nj : index->matches(s, index->partID(n->id), t))
+            {
+                all_pairs << qMakePair(n->id, index->partName(nj));
+            }
+        }
+
+        ResolveCorrespondence(source.data(), target.data(), all_pairs, gcorr.data());
+    }
+
+    gcorr->computeCorrespondences();
+    if(isCancelled.load()){ post(Result(), true); return; }
+
+    // Schedule blending sequence
+    auto scheduler = QSharedPointer<Scheduler>(new Scheduler);
+    auto blender = QSharedPointer<TopoBlender>(new TopoBlender(gcorr.data(), scheduler.data()));
+
+    // Sample geometries
+    int numSamples = 100;
+    int reconLevel = 4;
+
+    switch (LOD){
+        case 0: numSamples = 100; reconLevel = 4; break;
+        case 1: numSamples = 1000; reconLevel = 5; break;
+        case 2: numSamples = 10000; reconLevel = 7; break;
+    }
+
+    auto synthManager = QSharedPointer<SynthesisManager>(new SynthesisManager(gcorr.data(), scheduler.data(), blender.data(), numSamples));
+    synthManager->genSynData();
+    if(isCancelled.load()){ post(Result(), true); return; }
+
+    // Compute blending
+    scheduler->timeStep = 1.0 / 100.0;
+    scheduler->defaultSchedule();
+    scheduler->executeAll();
+
+    for (int i = 0; i < numResults; i++)
+    {
+        if(isCancelled.load()) break;
+
+        double a = ((double(i) / (numResults - 1)) * 0.9) + 0.05;
+        auto blendedModel = scheduler->allGraphs[a * (scheduler->allGraphs.size() - 1)];
+
+        synthManager->renderGraph(*blendedModel, "", false, reconLevel );
+
+        Result result;
+        result.name = QString("%1_%2").arg(sourceName).arg(targetName);
+
+        // Add parts of target shape
+        for (auto n : blendedModel->nodes){
+            result.parts << toBasicMesh(blendedModel->getMesh(n->id), n->vis_property["color"].value<QColor>());
+        }
+
+        post(result, false);
+    }
+
+    post(Result(), true);
+}
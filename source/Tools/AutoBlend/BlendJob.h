@@ -0,0 +1,45 @@
+#pragma once
+#include <QObject>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include "BasicMesh.h"
+
+class Document;
+
+// Blends one source/target pair on a worker thread. Each in-between shape is handed to the
+// GUI thread as soon as it is rendered, cancel() stops at the next stage or in-between
+class BlendJob : public QObject
+{
+    Q_OBJECT
+public:
+    BlendJob(Document * document, QString sourceName, QString targetName, int numResults, int LOD);
+
+    Document * document;
+    QString sourceName, targetName;
+    int numResults, LOD;
+
+    // Runs on a worker thread
+    void run();
+
+    QAtomicInt isCancelled;
+    void cancel(){ isCancelled.store(1); }
+
+protected:
+    struct Result{
+        QString name;
+        QVector<QBasicMesh> parts;
+    };
+    QMutex readyLock;
+    QVector<Result> ready;
+    bool isDone;
+
+    void post(const Result & result, bool isLast);
+
+protected slots:
+    void deliver();
+
+signals:
+    void resultReady(QString name, QVector<QBasicMesh> parts);
+    void finished();
+};
@@ -0,0 +1,189 @@
+#include "Embedding.h"
+#include <Eigen/Eigenvalues>
+#include <random>
+
+Embedding::Points Embedding::classicalMDS(const Eigen::MatrixXd & D, int dim)
+{
+    int n = D.rows();
+    Points X = Points::Zero(n, dim);
+    if(n == 0) return X;
+
+    // B = -1/2 J D^2 J
+    Eigen::MatrixXd B = D.array().square().matrix();
+    Eigen::VectorXd rowMean = B.rowwise().mean();
+    double mean = rowMean.mean();
+    B.rowwise() -= rowMean.transpose();
+    B.colwise() -= rowMean;
+    B.array() += mean;
+    B *= -0.5;
+
+    // Eigenvalues come in increasing order
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver(B);
+    for(int k = 0; k < dim && k < n; k++)
+    {
+        double lambda = solver.eigenvalues()[n - 1 - k];
+        if(lambda <= 0) continue;
+        X.col(k) = solver.eigenvectors().col(n - 1 - k) * std::sqrt(lambda);
+    }
+
+    return X;
+}
+
+Embedding::Points Embedding::triangulate(const Eigen::MatrixXd & C, const Points & Y)
+{
+    int n = C.rows(), k = Y.rows(), dim = Y.cols();
+    Points X = Points::Zero(n, dim);
+    if(k == 0) return X;
+
+    // Centered landmarks, mu_l is the mean squared distance from landmark l to the others
+    Points Yc = Y.rowwise() - Y.colwise().mean();
+    Eigen::VectorXd mu = Eigen::VectorXd::Zero(k);
+    for(int l = 0; l < k; l++)
+        for(int m = 0; m < k; m++) mu[l] += (Yc.row(l) - Yc.row(m)).squaredNorm() / k;
+
+    // x = -1/2 (Y^T Y)^-1 Y^T (c^2 - mu), the pseudo-inverse copes with degenerate landmark layouts
+    Eigen::MatrixXd YtY = Yc.transpose() * Yc;
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver(YtY);
+    Eigen::VectorXd inverse = Eigen::VectorXd::Zero(dim);
+    for(int d = 0; d < dim; d++)
+        if(solver.eigenvalues()[d] > 1e-12 * solver.eigenvalues().maxCoeff())
+            inverse[d] = 1.0 / solver.eigenvalues()[d];
+    Eigen::MatrixXd pinv = solver.eigenvectors() * inverse.asDiagonal() * solver.eigenvectors().transpose() * Yc.transpose();
+
+    #pragma omp parallel for schedule(static)
+    for(int i = 0; i < n; i++)
+    {
+        Eigen::VectorXd delta = C.row(i).transpose().array().square().matrix() - mu;
+        X.row(i) = (-0.5 * pinv * delta).transpose();
+    }
+
+    // Back to the frame of the given landmarks
+    X.rowwise() += Y.colwise().mean();
+    return X;
+}
+
+double Embedding::stress(const Eigen::MatrixXd & D, const Points & X)
+{
+    int n = D.rows();
+    double sum = 0;
+
+    #pragma omp parallel for reduction(+:sum) schedule(dynamic, 16)
+    for(int i = 0; i < n; i++)
+        for(int j = i + 1; j < n; j++)
+        {
+            double r = D(j, i) - (X.row(i) - X.row(j)).norm();
+            sum += r * r;
+        }
+
+    return sum;
+}
+
+Embedding::Points Embedding::smacof(const Eigen::MatrixXd & D, const Points & X0, int dim, int maxIter,
+                                    double tolerance, int * iterations)
+{
+    int n = D.rows();
+    Points X = (X0.rows() == n && X0.cols() == dim) ? X0 : classicalMDS(D, dim);
+    Points Z(n, dim);
+
+    double previousStress = -1;
+
+    int it = 0;
+    while(it < maxIter && n > 1)
+    {
+        double currentStress = 0;
+
+        // Guttman transform Z = B(X) X / n, computed per row without forming B.
+        // The stress of X comes from the same distances
+        #pragma omp parallel for reduction(+:currentStress) schedule(static)
+        for(int i = 0; i < n; i++)
+        {
+            auto xi = X.row(i);
+            const double * Di = D.col(i).data();
+
+            Eigen::RowVectorXd acc = Eigen::RowVectorXd::Zero(dim);
+            double bii = 0;
+
+            for(int j = 0; j < n; j++)
+            {
+                if(j == i) continue;
+                double dij = (xi - X.row(j)).norm();
+                currentStress += 0.5 * (Di[j] - dij) * (Di[j] - dij);
+                if(dij < 1e-12) continue;
+
+                double b = Di[j] / dij;
+                acc.noalias() += b * X.row(j);
+                bii += b;
+            }
+
+            Z.row(i) = (bii * xi - acc) / n;
+        }
+
+        // Stress of the previous layout was already low enough, keep it
+        if(previousStress >= 0 && (previousStress - currentStress) < tolerance * previousStress) break;
+        previousStress = currentStress;
+
+        X.swap(Z);
+        it++;
+    }
+
+    if(iterations) *iterations = it;
+    return X;
+}
+
+Embedding::Points Embedding::ucf(const Eigen::MatrixXd & D, const Points & X0, int dim, int maxIter,
+                                 double tolerance, int * iterations)
+{
+    int n = D.rows();
+    std::mt19937 rng(0);
+
+    Points X;
+    if(X0.rows() == n && X0.cols() == dim)
+        X = X0;
+    else
+    {
+        // Small random cloud scaled to the distances, before scaling mean distance is 1/3 sqrt(dim)
+        std::uniform_real_distribution<double> uniform(-0.5, 0.5);
+        X = Points(n, dim);
+        for(int i = 0; i < X.size(); i++) X.data()[i] = uniform(rng);
+        X *= 0.1 * D.mean() / (1.0 / 3.0 * std::sqrt(double(dim)));
+    }
+
+    const double lr = 0.05;
+    std::vector<int> order(n);
+    for(int i = 0; i < n; i++) order[i] = i;
+
+    double previousStress = stress(D, X);
+
+    int it = 0;
+    while(it < maxIter && n > 1)
+    {
+        std::shuffle(order.begin(), order.end(), rng);
+
+        // Pull every other point towards its target distance from m
+        for(int m : order)
+        {
+            Eigen::RowVectorXd xm = X.row(m);
+            const double * Dm = D.col(m).data();
+
+            #pragma omp parallel for schedule(static)
+            for(int i = 0; i < n; i++)
+            {
+                if(i == m) continue;
+                Eigen::RowVectorXd p = xm - X.row(i);
+                double d = p.norm();
+                if(d < 1e-12) continue;
+                X.row(i) += (lr * (d - Dm[i]) / d) * p;
+            }
+        }
+
+        it++;
+
+        double currentStress = stress(D, X);
+        bool isConverged = previousStress <= 0 || std::abs(previousStress - currentStress) < tolerance * previousStress;
+        previousStress = currentStress;
+        if(isConverged) break;
+    }
+
+    if(iterations) *iterations = it;
+    return X;
+}
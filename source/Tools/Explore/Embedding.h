@@ -0,0 +1,26 @@
+#pragma once
+#include <Eigen/Core>
+
+// Metric embeddings of a symmetric distance matrix, one point per row
+namespace Embedding{
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Points;
+
+    // Classical (Torgerson) MDS from the top eigenvectors of the double centered squared distances
+    Points classicalMDS(const Eigen::MatrixXd & D, int dim = 2);
+
+    // SMACOF stress majorization with rows updated in parallel, starts from X0 or classical MDS when X0 is empty.
+    // Stops after maxIter Guttman transforms or once the relative decrease of stress drops below tolerance
+    Points smacof(const Eigen::MatrixXd & D, const Points & X0, int dim = 2, int maxIter = 200,
+                  double tolerance = 1e-6, int * iterations = nullptr);
+
+    // Stochastic update of one point against all others at a time, as smat::MDS_UCF with r = 2
+    Points ucf(const Eigen::MatrixXd & D, const Points & X0, int dim = 2, int maxIter = 200,
+               double tolerance = 1e-6, int * iterations = nullptr);
+
+    // Landmark MDS: places every point from its distances C (n x k) to the k landmarks laid out in Y,
+    // as the least squares solution of |x - y_l| = C_l. Exact for landmarks and distances a layout can realize
+    Points triangulate(const Eigen::MatrixXd & C, const Points & Y);
+
+    // Raw stress, sum over pairs of (D_ij - |x_i - x_j|)^2
+    double stress(const Eigen::MatrixXd & D, const Points & X);
+}
@@ -13,7 +13,8 @@
 
 #include <QGraphicsDropShadowEffect>
 
-Explore::Explore(Document *document, const QRectF &bounds) : Tool(document), liveView(nullptr)
+Explore::Explore(Document *document, const QRectF &bounds) : Tool(document),
+    highlighted(-1, -1), isLinesDimmed(false), liveView(nullptr)
 {
     // Enable keyboard
     this->setFlags(QGraphicsItem::ItemIsFocusable);
@@ -71,22 +72,46 @@ void Explore::init()
 
             auto catModels = document->categories[ document->currentCategory ].toStringList();
 
-            // Build distance matrix
-            for(int i = 0; i < catModels.size(); i++)
-            {
-                for(int j = i+1; j < catModels.size(); j++)
-                {
-                    auto s = catModels[i], t = catModels[j];
+            // Build distance matrix, only the landmark columns when the category was matched with landmarks
+            distMat.clear();
+            auto pairDistance = [&](int i, int j){
+                auto s = catModels[i], t = catModels[j];
+                return std::max(document->datasetMatching[s][t]["min_cost"].toDouble(),
+                                document->datasetMatching[t][s]["min_cost"].toDouble());
+            };
 
-                    double dist = std::max(document->datasetMatching[s][t]["min_cost"].toDouble(),
-                                           document->datasetMatching[t][s]["min_cost"].toDouble());
+            QVector<int> landmarks;
+            for(auto name : document->landmarks.value(document->currentCategory))
+                if(catModels.contains(name)) landmarks << catModels.indexOf(name);
 
-                    distMat[i][j] = distMat[j][i] = dist;
-                }
+            if(landmarks.isEmpty())
+            {
+                for(int i = 0; i < catModels.size(); i++)
+                    for(int j = i+1; j < catModels.size(); j++)
+                        distMat[i][j] = distMat[j][i] = pairDistance(i, j);
+            }
+            else
+            {
+                for(int l : landmarks)
+                    for(int j = 0; j < catModels.size(); j++)
+                        if(j != l) distMat[l][j] = distMat[j][l] = pairDistance(l, j);
             }
 
             // MDS
-            auto allPoints = ExploreProcess::embed(distMat, widget->vizOption->currentIndex());
+            auto layoutKey = QString("%1/%2").arg(document->currentCategory).arg(widget->vizOption->currentIndex());
+            if(landmarks.isEmpty())
+                layout = ExploreProcess::embed(distMat, widget->vizOption->currentIndex(), layouts[layoutKey]);
+            else
+            {
+                QVector< QVector<double> > landmarkDistances(catModels.size(), QVector<double>(landmarks.size(), 0));
+                for(int i = 0; i < catModels.size(); i++)
+                    for(int l = 0; l < landmarks.size(); l++)
+                        landmarkDistances[i][l] = distMat[i].value(landmarks[l], 0);
+
+                layout = ExploreProcess::embedLandmarks(landmarkDistances, landmarks, widget->vizOption->currentIndex(), layouts[layoutKey]);
+            }
+            layouts[layoutKey] = layout;
+            auto allPoints = layout;
             auto allPointsRect = allPoints.boundingRect();
 
             // Rescale and position points
@@ -131,7 +156,7 @@ void Explore::init()
             maximumColumn.fill(-1, catModels.size());
             for(int i = 0; i < catModels.size(); i++){
                 for(int j = 0; j < catModels.size(); j++){
-                    auto d = distMat[i][j];
+                    auto d = distance(i, j);
 
                     maximumColumn[i] = std::max(maximumColumn[i], d);
 
@@ -157,7 +182,7 @@ void Explore::init()
                     QLineF linef(this->mapFromItem(t1, t1->boundingRect().center()),
                                  this->mapFromItem(t2, t2->boundingRect().center()));
 
-                    double similarity = 1.0 - ((distMat[i][j] - min_val) / (max_val - min_val));
+                    double similarity = 1.0 - ((distance(i, j) - min_val) / (max_val - min_val));
 
 					similarity = pow(similarity, 3);
 
@@ -169,7 +194,7 @@ void Explore::init()
                             if (edge.first < 0 || edge.second < 0) continue;
                             bool test1 = edge.first == i && edge.second == j;
                             bool test2 = edge.second == i && edge.first == j;
-                            bool test3 = bestCost == distMat[i][j];
+                            bool test3 = bestCost == distance(i, j);
 
 							if (test1 || test2 || test3)
                             {
@@ -191,6 +216,8 @@ void Explore::init()
                 }
             }
 
+            indexLines();
+
             // Live synthesis
             liveView = new ExploreLiveView(this, document);
             //auto ritem = new QGraphicsRectItem(QRectF(-5,-5,10,10), liveView);
@@ -199,41 +226,75 @@ void Explore::init()
     }
 }
 
+double Explore::distance(int i, int j) const
+{
+    if(i == j) return 0;
+
+    // Pairs without a landmark were never matched, their layout distance stands in
+    auto row = distMat.value(i);
+    if(row.contains(j)) return row[j];
+    return QLineF(layout.value(i), layout.value(j)).length();
+}
+
+void Explore::indexLines()
+{
+    QRectF extent(0, 0, bounds.width(), bounds.height());
+    for(auto l : lines) extent |= QRectF(l->line().p1(), l->line().p2()).normalized();
+
+    lineIndex.build(extent, lines.size());
+    lineKeys.clear();
+    for(auto key : lines.keys()) addLineToIndex(key);
+
+    highlighted = qMakePair(-1, -1);
+    isLinesDimmed = false;
+}
+
+void Explore::addLineToIndex(QPair<int,int> key)
+{
+    lineIndex.insert(lines[key]->line());
+    lineKeys << key;
+}
+
+static void styleLine(QGraphicsLineItem * l, bool isHighlighted)
+{
+    auto pen = l->pen();
+    auto color = pen.color();
+    color.setAlphaF(isHighlighted ? 1 : 0.25);
+    pen.setColor(color);
+    pen.setWidth(isHighlighted ? 4 : 1);
+    l->setPen(pen);
+}
+
 void Explore::mouseMoveEvent(QGraphicsSceneMouseEvent * event)
 {
     if(liveView == nullptr || lines.empty()) return;
     if(event->buttons().testFlag(Qt::RightButton)) return;
 
-    auto pointLineDist = [&](QPointF p, QLineF l, QPointF & projection){
-        QVector2D v (l.p2() - l.p1());
-        QVector2D w (p - l.p1());
-        auto c1 = QVector2D::dotProduct(w,v);
-        if ( c1 <= 0 ) {projection = l.p1(); return QVector2D(p - l.p1()).length();}
-        auto c2 = QVector2D::dotProduct(v,v);
-        if ( c2 <= c1 ) {projection = l.p2(); return QVector2D(p - l.p2()).length();}
-        auto b = c1 / c2;
-        QVector2D Pb (QVector2D(l.p1()) + b * v);
-        projection = Pb.toPointF();
-        return (QVector2D(p) - Pb).length();
-    };
-
-    QMap< double, QPair<int,int> > dists;
-    for(auto key : lines.keys())
+    // Closest lines, a key can be indexed twice when a link is added again
+    QList< QPair<int,int> > closest;
+    for(auto hit : lineIndex.nearest(event->pos(), 4))
     {
-        auto l = lines[key];
-        auto line = l->line();
+        auto key = lineKeys[hit.second];
+        if(!closest.contains(key)) closest << key;
+    }
+    if(closest.isEmpty()) return;
 
-        QPointF proj;
-        double dist = pointLineDist(event->pos(), line, proj);
+    auto best = closest.front();
+    auto bestLine = lines[best];
 
-        dists[dist] = key;
+    // Change visualization, all lines are dimmed once and then only the highlight moves
+    if(!isLinesDimmed)
+    {
+        for(auto l : lines) styleLine(l, false);
+        isLinesDimmed = true;
+        highlighted = qMakePair(-1, -1);
+    }
 
-        auto pen = l->pen();
-        auto color = pen.color();
-        color.setAlphaF(0.25);
-        pen.setColor(color);
-        pen.setWidth(1);
-        l->setPen(pen);
+    if(best != highlighted)
+    {
+        if(lines.contains(highlighted)) styleLine(lines[highlighted], false);
+        styleLine(bestLine, true);
+        highlighted = best;
     }
 
     // Blend details
@@ -241,22 +302,9 @@ void Explore::mouseMoveEvent(QGraphicsSceneMouseEvent * event)
 
     // Find projection online
     {
-        // Closest line
-        auto key = dists.keys().front();
-        auto best = dists[key];
-        auto bestLine = lines[best];
-
-        // Change visualization
-        auto pen = bestLine->pen();
-        auto color = pen.color();
-        color.setAlphaF(1);
-        pen.setColor(color);
-        pen.setWidth(4);
-        bestLine->setPen(pen);
-
         // Project on best line
         QPointF proj;
-        pointLineDist(event->pos(),bestLine->line(),proj);
+        SegmentGrid::distance(event->pos(),bestLine->line(),proj);
         liveView->setPos(proj);
 
         auto catModels = document->categories[ document->currentCategory ].toStringList();
@@ -274,6 +322,17 @@ void Explore::mouseMoveEvent(QGraphicsSceneMouseEvent * event)
     info["alpha"].setValue(alpha);
     info["hqRendering"].setValue(widget->hqRendering->isChecked());
     liveView->showBlend( info );
+
+    // Prepare the next closest edges in the background
+    {
+        auto catModels = document->categories[ document->currentCategory ].toStringList();
+
+        QList< QPair<QString,QString> > nearby;
+        for(auto key : closest.mid(1, 2))
+            nearby << qMakePair(catModels[key.first], catModels[key.second]);
+
+        liveView->prefetch(nearby);
+    }
 }
 
 void Explore::mousePressEvent(QGraphicsSceneMouseEvent *  event)
@@ -337,7 +396,7 @@ void Explore::mouseReleaseEvent(QGraphicsSceneMouseEvent *  event)
         QLineF linef(this->mapFromItem(t1, t1->boundingRect().center()),
                      this->mapFromItem(t2, t2->boundingRect().center()));
 
-        double similarity = 1.0 - ((distMat[i][j] - min_val) / (max_val - min_val));
+        double similarity = 1.0 - ((distance(i, j) - min_val) / (max_val - min_val));
         similarity = pow(similarity, 3);
 
         QColor color = ExploreProcess::qtJetColor(similarity);
@@ -348,6 +407,10 @@ void Explore::mouseReleaseEvent(QGraphicsSceneMouseEvent *  event)
         line->setZValue(-1);
 
         lines[qMakePair(i,j)] = line;
+        addLineToIndex(qMakePair(i,j));
+
+        // Match the lines already dimmed while hovering
+        if(isLinesDimmed) styleLine(line, false);
     }
 }
 
@@ -2,6 +2,7 @@
 #include "Tool.h"
 #include <QMatrix4x4>
 #include <QMap>
+#include "SegmentGrid.h"
 
 namespace Ui{ class ExploreWidget; }
 class Thumbnail;
@@ -20,6 +21,14 @@ protected:
     QMap<QString, Thumbnail*> thumbs;
     QMap<QPair<int,int>, QGraphicsLineItem*> lines;
 
+    // Hit testing of lines, only the highlighted line changes style on hover
+    SegmentGrid lineIndex;
+    QVector< QPair<int,int> > lineKeys;
+    QPair<int,int> highlighted;
+    bool isLinesDimmed;
+    void indexLines();
+    void addLineToIndex(QPair<int,int> key);
+
     ExploreLiveView * liveView;
 
     QMatrix4x4 cameraMatrix;
@@ -34,6 +43,10 @@ protected:
     QString startShape, targetShape;
     double alpha;
 
+    // Matched distances, only landmark rows for large categories
     QMap<int, QMap<int,double> > distMat;
+    QPolygonF layout;
+    double distance(int i, int j) const;
+    QMap<QString, QPolygonF> layouts;
     double max_val, min_val;
 };
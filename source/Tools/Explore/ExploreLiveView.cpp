@@ -2,47 +2,203 @@
 #include <QPainter>
 #include <QGraphicsScene>
 #include <QGraphicsView>
+#include <QtConcurrent>
+#include <QFutureWatcher>
 
 #include "Document.h"
 
 #include "Viewer.h"
-#include <QOpenGLFramebufferObject>
-#include <QOffscreenSurface>
-#include <QOpenGLFunctions>
+#include "OffscreenRenderer.h"
 
 #include "ExploreProcess.h"
 
 ExploreLiveView::ExploreLiveView(QGraphicsItem *parent, Document *document) : QGraphicsObject(parent),
-    document(document), isReady(false), isCacheImage(false), cacheImageSize(512)
+    document(document), isReady(false), isCacheImage(false), cacheImageSize(512), maxCachedPaths(4)
 {
 	this->setFlag(QGraphicsItem::ItemIsSelectable);
 	this->setFlag(QGraphicsItem::ItemIsMovable);
+
+    // Hovered paths never wait behind speculative ones
+    preparePool.setMaxThreadCount(1);
+    prefetchPool.setMaxThreadCount(1);
+    fillPool.setMaxThreadCount(1);
+}
+
+ExploreLiveView::~ExploreLiveView()
+{
+    for(auto key : preparing.keys() + filling.keys()) blendPath[key]->cancel();
+    preparePool.waitForDone();
+    prefetchPool.waitForDone();
+    fillPool.waitForDone();
+}
+
+QSharedPointer<ExploreProcess::BlendPath> ExploreLiveView::pathFor(PathKey key)
+{
+	if (!blendPath.contains(key))
+	{
+		auto path = QSharedPointer<ExploreProcess::BlendPath>(new ExploreProcess::BlendPath);
+		path->source = key.first;
+		path->target = key.second;
+		blendPath[key] = path;
+	}
+
+	return blendPath[key];
+}
+
+void ExploreLiveView::startPreparing(PathKey key, bool isSpeculative)
+{
+    if(preparing.contains(key))
+    {
+        // Still running, possibly cancelled, it is restarted when it finishes. A hovered path still
+        // queued behind speculative ones takes over the run and moves to the hovered pool
+        if(isSpeculative || !claims[key]->testAndSetOrdered(0, 1)) return;
+        preparing.remove(key);
+    }
+
+    auto path = pathFor(key);
+    if(path->isReady || failedPaths.contains(key)) return;
+
+    path->isCancelled.store(0);
+
+    // Whichever run claims the path first prepares it
+    auto doc = document;
+    auto claim = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    auto future = QtConcurrent::run(isSpeculative ? &prefetchPool : &preparePool, [path, doc, claim](){
+        if(claim->testAndSetOrdered(0, 1)) path->prepare(doc);
+    });
+    preparing[key] = future;
+    claims[key] = claim;
+
+    auto watcher = new QFutureWatcher<void>(this);
+    connect(watcher, &QFutureWatcher<void>::finished, this, [=](){
+        watcher->deleteLater();
+
+        // Taken over by a hovered run
+        if(preparing.value(key) != future) return;
+
+        preparing.remove(key);
+        claims.remove(key);
+
+        auto currentKey = qMakePair(currentInfo["source"].toString(), currentInfo["target"].toString());
+
+        // Shapes could not be blended, not worth retrying
+        if(!path->isReady && !path->isCancelled.load()) failedPaths << key;
+
+        // Cancelled while the cursor came back to it
+        if(!path->isReady && path->isCancelled.load() && (key == currentKey || prefetchKeys.contains(key)))
+        {
+            startPreparing(key, key != currentKey);
+            return;
+        }
+
+        if(key == currentKey) showBlend(currentInfo);
+        releaseUnused();
+    });
+    watcher->setFuture(future);
+}
+
+void ExploreLiveView::startFilling(PathKey key)
+{
+    auto path = pathFor(key);
+
+    // Older paths give up their frames, those still filling when they finish
+    recentPaths.removeAll(key);
+    recentPaths.prepend(key);
+    while(recentPaths.size() > maxCachedPaths)
+    {
+        auto old = recentPaths.takeLast();
+        if(!filling.contains(old)) blendPath[old]->clearFrames();
+    }
+
+    if(filling.contains(key) || path->isFilled) return;
+
+    path->isCancelled.store(0);
+
+    double alpha = path->alpha;
+    auto future = QtConcurrent::run(&fillPool, [path, alpha](){ path->fillFrames(alpha); });
+    filling[key] = future;
+
+    auto watcher = new QFutureWatcher<void>(this);
+    connect(watcher, &QFutureWatcher<void>::finished, this, [=](){
+        watcher->deleteLater();
+        filling.remove(key);
+
+        // Dropped out of the recent paths while filling
+        if(!recentPaths.contains(key)) path->clearFrames();
+
+        // Replace a stand-in frame with the exact one
+        auto currentKey = qMakePair(currentInfo["source"].toString(), currentInfo["target"].toString());
+        if(key == currentKey) showBlend(currentInfo);
+        releaseUnused();
+    });
+    watcher->setFuture(future);
+}
+
+void ExploreLiveView::releaseUnused()
+{
+    auto currentKey = qMakePair(currentInfo["source"].toString(), currentInfo["target"].toString());
+
+    // Prepared blends are kept for the current, prefetched and recently shown paths only
+    for(auto key : blendPath.keys())
+    {
+        bool isWanted = key == currentKey || prefetchKeys.contains(key) || recentPaths.contains(key);
+        if(isWanted || preparing.contains(key) || filling.contains(key)) continue;
+        blendPath.remove(key);
+    }
+}
+
+void ExploreLiveView::cancelUnwanted()
+{
+    auto currentKey = qMakePair(currentInfo["source"].toString(), currentInfo["target"].toString());
+
+    for(auto key : preparing.keys())
+    {
+        if(key == currentKey || prefetchKeys.contains(key)) continue;
+        blendPath[key]->cancel();
+    }
+
+    for(auto key : filling.keys())
+    {
+        if(key == currentKey) continue;
+        blendPath[key]->cancel();
+    }
 }
 
 void ExploreLiveView::showBlend(QVariantMap info)
 {
     this->isReady = false;
+    this->currentInfo = info;
 
 	QString source = info["source"].toString();
 	QString target = info["target"].toString();
 	double alpha = info["alpha"].toDouble();
 
 	auto key = qMakePair(source, target);
+	auto path = pathFor(key);
 
-	if (!blendPath.contains(key))
-		blendPath[key] = QSharedPointer<ExploreProcess::BlendPath>(new ExploreProcess::BlendPath);
-
-	auto & path = blendPath[qMakePair(source, target)];
-
-	path->source = source;
-	path->target = target;
 	path->alpha = std::min(1.0, std::max(0.0, alpha));
-	path->prepare(document);
 
 	this->shapeRect = QRectF(0, 0, 128, 128);
 
+	cancelUnwanted();
+	releaseUnused();
+
+	if (preparing.contains(key) || !path->isReady)
+	{
+		// Placeholder until the background preparation finishes
+		startPreparing(key, false);
+		meshes.clear();
+		message = failedPaths.contains(key) ? "No blend" : "Preparing...";
+		update();
+		return;
+	}
+
+    message.clear();
     meshes = path->blend();
 
+    // Remaining frames of this path are synthesized in the background
+    startFilling(key);
+
     if(info["hqRendering"].toBool())
     {
         this->isCacheImage = true;
@@ -50,11 +206,32 @@ void ExploreLiveView::showBlend(QVariantMap info)
     }
 
     this->isReady = true;
+    update();
+}
+
+void ExploreLiveView::prefetch(QList<PathKey> keys)
+{
+    prefetchKeys = keys;
+    cancelUnwanted();
+    releaseUnused();
+
+    for(auto key : keys) startPreparing(key, true);
 }
 
 void ExploreLiveView::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget * widget)
 {
-    if(!isReady) return;
+    if(!isReady)
+    {
+        if(message.isEmpty()) return;
+
+        postPaint(painter);
+
+        QRectF circle = shapeRect;
+        circle.moveCenter(QPointF(0, 0));
+        painter->setPen(Qt::white);
+        painter->drawText(circle, Qt::AlignCenter, message);
+        return;
+    }
 
 	prePaint(painter);
 
@@ -67,53 +244,9 @@ void ExploreLiveView::paint(QPainter *painter, const QStyleOptionGraphicsItem *,
 
         if (isCacheImage && cachedImage.isNull())
         {
-            QOpenGLContext context;
-            context.setShareContext(glwidget->context());
-            context.setFormat(glwidget->format());
-            context.create();
-
-            QOffscreenSurface m_offscreenSurface;
-            m_offscreenSurface.setFormat(context.format());
-            m_offscreenSurface.create();
-
-            context.makeCurrent(&m_offscreenSurface);
-
-            QOpenGLFramebufferObjectFormat fboformat;
-            fboformat.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
-            QOpenGLFramebufferObject renderFbo(cacheImageSize*1.5, cacheImageSize, fboformat);
-            renderFbo.bind();
-
-            glwidget->glEnable(GL_DEPTH_TEST);
-            glwidget->glEnable(GL_BLEND);
-            glwidget->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glwidget->glCullFace(GL_BACK);
-
-            glwidget->glClearColor(0,0,0,0);
-            glwidget->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            glwidget->glViewport(0, 0, cacheImageSize*1.5, cacheImageSize);
-
-	// XXX Fix
-            // glwidget->glPointSize(10);	
-
-            // Draw aux meshes
-            for (auto mesh : meshes)
-            {
-                if (mesh.isPoints)
-                    glwidget->drawOrientedPoints(mesh.points, mesh.normals, mesh.color, glwidget->pvm);
-                else
-                    glwidget->drawTriangles(mesh.color, mesh.points, mesh.normals, glwidget->pvm);
-            }
-
-            glwidget->glDisable(GL_DEPTH_TEST);
-            glwidget->glFlush();
-
-            renderFbo.release();
-
-            cachedImage = renderFbo.toImage();
+            auto size = QSize(cacheImageSize*1.5, cacheImageSize);
+            cachedImage = OffscreenRenderer::of(glwidget)->render(size, meshes, glwidget->pvm);
             isReady = true;
-
-            // Thanks for sharing!
-            glwidget->makeCurrent();
         }
 
         // Draw as image
@@ -1,6 +1,9 @@
 #pragma once
 #include <QGraphicsObject>
 #include <QVector3D>
+#include <QThreadPool>
+#include <QFuture>
+#include <QSet>
 
 class Document;
 namespace ExploreProcess{  struct BlendPath; }
@@ -12,11 +15,16 @@ class ExploreLiveView : public QGraphicsObject
     Q_OBJECT
 public:
     ExploreLiveView(QGraphicsItem *parent, Document * document);
+    ~ExploreLiveView();
 
     QRectF boundingRect() const { return childrenBoundingRect(); }
 
+    // Paths are prepared in the background, a placeholder is shown until the hovered one is ready
     void showBlend(QVariantMap info);
 
+    // Speculatively prepare paths the cursor is likely to reach next, others in flight are cancelled
+    void prefetch(QList< QPair<QString,QString> > keys);
+
     bool isReady;
     bool isCacheImage;
     QImage cachedImage;
@@ -31,6 +39,26 @@ protected:
 
     QMap< QPair<QString,QString>, QSharedPointer<ExploreProcess::BlendPath> > blendPath;
 
+    typedef QPair<QString,QString> PathKey;
+    QSharedPointer<ExploreProcess::BlendPath> pathFor(PathKey key);
+    void startPreparing(PathKey key, bool isSpeculative);
+    void startFilling(PathKey key);
+    void cancelUnwanted();
+    void releaseUnused();
+
+    QVariantMap currentInfo;
+    QList<PathKey> prefetchKeys;
+    QMap< PathKey, QFuture<void> > preparing;
+    QMap< PathKey, QSharedPointer<QAtomicInt> > claims;
+    QSet<PathKey> failedPaths;
+    QThreadPool preparePool, prefetchPool;
+
+    // Frame caches are kept for the most recently shown paths only
+    QMap< PathKey, QFuture<void> > filling;
+    QList<PathKey> recentPaths;
+    int maxCachedPaths;
+    QThreadPool fillPool;
+
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *);
     void prePaint(QPainter *painter);
     void postPaint(QPainter *painter);
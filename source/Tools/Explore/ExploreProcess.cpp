@@ -6,7 +6,7 @@
 
 #include "DivergingColorMaps.hpp"
 
-#include "SimpleMatrix.h"
+#include "Embedding.h"
 
 #include "voronoi.hpp"
 using namespace cinekine;
@@ -53,26 +53,6 @@ QPair<QVector3D,QMatrix4x4> ExploreProcess::defaultCamera(double zoomFactor, int
     return qMakePair(cameraPos,cameraMatrix);
 }
 
-// From surface mesh to basic mesh
-Thumbnail::QBasicMesh ExploreProcess::toBasicMesh (opengp::SurfaceMesh::SurfaceMeshModel * m, QColor color)
-{
-    Thumbnail::QBasicMesh mesh;
-    m->update_face_normals();
-    for (auto f : m->faces()){
-        QVector<QVector3D> fp, fn;
-        for (auto vf : m->vertices(f)){
-            auto p = m->vertex_coordinates()[vf];
-            auto n = m->face_normals()[f];
-            fp << QVector3D(p[0], p[1], p[2]);
-            fn << QVector3D(n[0], n[1], n[2]);
-        }
-        mesh.addTri(fp[0], fp[1], fp[2], fn[0], fn[1], fn[2]);
-    }
-
-    mesh.color = color;
-    return mesh;
-}
-
 Thumbnail * ExploreProcess::makeThumbnail(QGraphicsItem * parent, Document * document, QString s, QPointF pos, bool hqRendering)
 {
     int defaultWidth = 150;
@@ -104,10 +84,15 @@ Thumbnail * ExploreProcess::makeThumbnail(QGraphicsItem * parent, Document * doc
     t->setProperty("isNoBackground", true);
     t->setProperty("isNoBorder", true);
 
-    // Add parts of target shape
-    auto m = document->cacheModel(s);
-    for (auto n : m->nodes){
-        t->addAuxMesh(toBasicMesh(m->getMesh(n->id), n->vis_property["color"].value<QColor>()));
+    // Add parts of target shape, unless a current cached image saves loading and rendering it
+    if(!t->setCacheFile(document->thumbnailFile(s, cameraMatrix, thumbRect.size().toSize())))
+    {
+        Document::PinnedModels pinned(document, QStringList() << s);
+        auto m = document->cacheModel(s);
+        if (m != nullptr){
+            for (auto n : m->nodes)
+                t->addAuxMesh(Thumbnail::toBasicMesh(m->getMesh(n->id), n->vis_property["color"].value<QColor>()));
+        }
     }
 
     t->setPos(pos - QPointF(defaultWidth * 0.5, defaultWidth * 0.5));
@@ -145,28 +130,71 @@ QColor ExploreProcess::qtJetColor(double v, double vmin, double vmax)
     return QColor::fromRgbF(qMax(0.0, qMin(r,1.0)), qMax(0.0, qMin(g,1.0)), qMax(0.0, qMin(b,1.0)));
 }
 
-QPolygonF ExploreProcess::embed(QMap<int, QMap<int, double> > distMatrix, int embedOption)
+QPolygonF ExploreProcess::embed(QMap<int, QMap<int, double> > distMatrix, int embedOption, QPolygonF previous)
 {
-    QSharedPointer< smat::Matrix<double> > X;
-    smat::Matrix<double> D(distMatrix.size(), distMatrix.size(), 0);
+    int n = distMatrix.size();
+    Eigen::MatrixXd D = Eigen::MatrixXd::Zero(n, n);
 
     for(auto i : distMatrix.keys())
     {
         for(auto j : distMatrix[i].keys())
         {
             double dist = distMatrix[i][j];
-            D.set(i,j,dist);
-            D.set(j,i,dist);
+            D(i,j) = D(j,i) = dist;
         }
     }
 
+    // Warm start from the earlier layout of the same shapes
+    Embedding::Points X0;
+    if(previous.size() == n)
+    {
+        X0.resize(n, 2);
+        for(int i = 0; i < n; i++) X0.row(i) << previous[i].x(), previous[i].y();
+    }
+
     // MDS
-    if(embedOption == 0) X = QSharedPointer< smat::Matrix<double> >(smat::MDS_SMACOF(&D, NULL, 2, 200));
-    if(embedOption == 1) X = QSharedPointer< smat::Matrix<double> >(smat::MDS_UCF(&D, NULL, 2, 200));
+    Embedding::Points X;
+    if(embedOption == 0) X = Embedding::smacof(D, X0, 2, 200);
+    if(embedOption == 1) X = Embedding::ucf(D, X0, 2, 200);
+
+    QPolygonF allPoints;
+    for(int i = 0; i < X.rows(); i++)
+        allPoints << QPointF(X(i,0), X(i,1));
+    return allPoints;
+}
+
+QPolygonF ExploreProcess::embedLandmarks(QVector< QVector<double> > landmarkDistances, QVector<int> landmarks,
+                                         int embedOption, QPolygonF previous)
+{
+    int n = landmarkDistances.size(), k = landmarks.size();
+    Eigen::MatrixXd C = Eigen::MatrixXd::Zero(n, k);
+    for(int i = 0; i < n; i++)
+        for(int l = 0; l < k && l < landmarkDistances[i].size(); l++)
+            C(i,l) = landmarkDistances[i][l];
+
+    Eigen::MatrixXd D(k, k);
+    for(int a = 0; a < k; a++)
+        for(int b = 0; b < k; b++)
+            D(a,b) = (a == b) ? 0 : std::max(C(landmarks[a], b), C(landmarks[b], a));
+
+    // Warm start the landmarks from the earlier layout of the same shapes
+    Embedding::Points Y0;
+    if(previous.size() == n)
+    {
+        Y0.resize(k, 2);
+        for(int l = 0; l < k; l++) Y0.row(l) << previous[landmarks[l]].x(), previous[landmarks[l]].y();
+    }
+
+    Embedding::Points Y;
+    if(embedOption == 0) Y = Embedding::smacof(D, Y0, 2, 200);
+    if(embedOption == 1) Y = Embedding::ucf(D, Y0, 2, 200);
+
+    Embedding::Points X = Embedding::triangulate(C, Y);
+    for(int l = 0; l < k; l++) X.row(landmarks[l]) = Y.row(l);
 
     QPolygonF allPoints;
-    for(int i = 0; i < D.rows(); i++)
-        allPoints << QPointF(X->get(i,0), X->get(i,1));
+    for(int i = 0; i < X.rows(); i++)
+        allPoints << QPointF(X(i,0), X(i,1));
     return allPoints;
 }
 
@@ -205,14 +233,26 @@ ExploreProcess::BasicVoronoiGraph ExploreProcess::buildGraph(QPolygonF points, d
 
 void ExploreProcess::BlendPath::prepare(Document *document)
 {
-    if(isReady) return;
+    if(isReady || isCancelled.load()) return;
+
+    // Models stay resident while they are cloned
+    document->pinModel(source);
+    document->pinModel(target);
 
     auto cacheSource = document->cacheModel(source);
     auto cacheTarget = document->cacheModel(target);
-    if(cacheSource == nullptr || cacheTarget == nullptr) return;
 
-    auto sourceShape = QSharedPointer<Structure::Graph>(cacheSource->cloneAsShapeGraph());
-    auto targetShape = QSharedPointer<Structure::Graph>(cacheTarget->cloneAsShapeGraph());
+    QSharedPointer<Structure::Graph> sourceShape, targetShape;
+    if(cacheSource && cacheTarget)
+    {
+        sourceShape = QSharedPointer<Structure::Graph>(cacheSource->cloneAsShapeGraph());
+        targetShape = QSharedPointer<Structure::Graph>(cacheTarget->cloneAsShapeGraph());
+    }
+
+    document->unpinModel(source);
+    document->unpinModel(target);
+
+    if(!sourceShape || !targetShape) return;
 
     gcorr = QSharedPointer<GraphCorresponder>(new GraphCorresponder(sourceShape.data(), targetShape.data()));
 
@@ -220,14 +260,14 @@ void ExploreProcess::BlendPath::prepare(Document *document)
     {
         QVector<QPair<QString, QString> > all_pairs;
 
+        auto index = document->corrIndex();
+        int s = index->shapeID(source), t = index->shapeID(target);
+
         for(auto n : sourceShape->nodes)
         {
-            if (!document->datasetCorr[source][n->id][target].empty())
+            for(auto nj : index->matches(s, index->partID(n->id), t))
             {
-                for(auto nj : document->datasetCorr[source][n->id][target])
-                {
-                    all_pairs << qMakePair(n->id, nj);
-                }
+                all_pairs << qMakePair(n->id, index->partName(nj));
             }
         }
 
@@ -235,6 +275,7 @@ void ExploreProcess::BlendPath::prepare(Document *document)
     }
 
     gcorr->computeCorrespondences();
+    if(isCancelled.load()) return;
 
     // Schedule blending sequence
     scheduler = QSharedPointer<Scheduler>(new Scheduler);
@@ -256,6 +297,7 @@ void ExploreProcess::BlendPath::prepare(Document *document)
     synthManager = QSharedPointer<SynthesisManager>(new SynthesisManager(gcorr.data(), scheduler.data(), blender.data(), numSamples));
     synthManager->genSynData();
     synthManager->property["reconLevel"].setValue(reconLevel);
+    if(isCancelled.load()) return;
 
     // Compute blending
     scheduler->timeStep = 1.0 / 100.0;
@@ -265,12 +307,16 @@ void ExploreProcess::BlendPath::prepare(Document *document)
     isReady = true;
 }
 
-QVector<Thumbnail::QBasicMesh> ExploreProcess::BlendPath::blend()
+int ExploreProcess::BlendPath::frameIndex(double a) const
+{
+    return a * (scheduler->allGraphs.size() - 1);
+}
+
+QVector<Thumbnail::QBasicMesh> ExploreProcess::BlendPath::synthesizeFrame(int index)
 {
     QVector<Thumbnail::QBasicMesh> parts;
-    if(!isReady) return parts;
 
-    auto activeGraph = scheduler->allGraphs[alpha * (scheduler->allGraphs.size() - 1)];
+    auto activeGraph = scheduler->allGraphs[index];
     auto all_parts = synthManager->constructShapeGeometry(activeGraph);
 
     for(auto part : all_parts)
@@ -287,3 +333,103 @@ QVector<Thumbnail::QBasicMesh> ExploreProcess::BlendPath::blend()
 
     return parts;
 }
+
+bool ExploreProcess::BlendPath::insertFrame(int index, const QVector<Thumbnail::QBasicMesh> & parts, bool isEvicting)
+{
+    qint64 bytes = 0;
+    for(auto & part : parts) bytes += (part.points.size() + part.normals.size()) * sizeof(QVector3D);
+
+    QMutexLocker locker(&framesLock);
+
+    // Frames farthest from the one being shown go first
+    while(isEvicting && !frames.isEmpty() && frameBytes + bytes > maxFrameBytes)
+    {
+        int farthest = std::abs(frames.firstKey() - index) > std::abs(frames.lastKey() - index) ? frames.firstKey() : frames.lastKey();
+        for(auto & part : frames[farthest]) frameBytes -= (part.points.size() + part.normals.size()) * sizeof(QVector3D);
+        frames.remove(farthest);
+        isFilled = false;
+    }
+
+    if(frameBytes + bytes > maxFrameBytes) return false;
+
+    frames[index] = parts;
+    frameBytes += bytes;
+    return true;
+}
+
+QVector<Thumbnail::QBasicMesh> ExploreProcess::BlendPath::blend()
+{
+    QVector<Thumbnail::QBasicMesh> parts;
+    if(!isReady) return parts;
+
+    int index = frameIndex(alpha);
+
+    {
+        QMutexLocker locker(&framesLock);
+        if(frames.contains(index)) return frames[index];
+    }
+
+    // A frame is being filled in, show the closest one meanwhile
+    if(!synthLock.tryLock())
+    {
+        {
+            QMutexLocker locker(&framesLock);
+            if(!frames.isEmpty())
+            {
+                auto after = frames.lowerBound(index);
+                if(after == frames.end()) return frames.last();
+                if(after == frames.begin()) return after.value();
+                auto before = after - 1;
+                return (index - before.key() <= after.key() - index) ? before.value() : after.value();
+            }
+        }
+        synthLock.lock();
+    }
+
+    parts = synthesizeFrame(index);
+    synthLock.unlock();
+
+    insertFrame(index, parts, true);
+
+    return parts;
+}
+
+void ExploreProcess::BlendPath::fillFrames(double fromAlpha)
+{
+    if(!isReady) return;
+
+    int count = scheduler->allGraphs.size();
+    int start = frameIndex(fromAlpha);
+
+    // Outward from the current frame, until the budget is used
+    for(int step = 0; step < count * 2; step++)
+    {
+        if(isCancelled.load()) return;
+
+        int index = start + ((step % 2) ? -(step + 1) / 2 : step / 2);
+        if(index < 0 || index >= count) continue;
+
+        {
+            QMutexLocker locker(&framesLock);
+            if(frames.contains(index)) continue;
+            if(frameBytes >= maxFrameBytes) break;
+        }
+
+        synthLock.lock();
+        auto parts = synthesizeFrame(index);
+        synthLock.unlock();
+
+        if(!insertFrame(index, parts, false)) break;
+    }
+
+    QMutexLocker locker(&framesLock);
+    isFilled = true;
+}
+
+void ExploreProcess::BlendPath::clearFrames()
+{
+    QMutexLocker locker(&framesLock);
+    frames.clear();
+    frameBytes = 0;
+    isFilled = false;
+}
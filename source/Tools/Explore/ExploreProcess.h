@@ -5,6 +5,8 @@
 #include <QMatrix4x4>
 
 #include <QSharedPointer>
+#include <QAtomicInt>
+#include <QMutex>
 
 class Document;
 
@@ -19,10 +21,14 @@ class SynthesisManager;
 
 namespace ExploreProcess{
     QPair<QVector3D, QMatrix4x4> defaultCamera(double zoomFactor, int width = 128, int height = 128);
-    Thumbnail::QBasicMesh toBasicMesh (opengp::SurfaceMesh::SurfaceMeshModel * m, QColor color);
     QColor qtJetColor (double v, double vmin = 0.0, double vmax = 1.0);
     Thumbnail * makeThumbnail(QGraphicsItem * parent, Document * document, QString s, QPointF pos, bool hqRendering);
-    QPolygonF embed(QMap<int, QMap<int, double > > distMatrix, int embedOption);
+    QPolygonF embed(QMap<int, QMap<int, double > > distMatrix, int embedOption, QPolygonF previous = QPolygonF());
+
+    // Lays out the landmarks from their own distances, then places every shape from its
+    // distances to the landmarks (one row per shape, one column per landmark)
+    QPolygonF embedLandmarks(QVector< QVector<double> > landmarkDistances, QVector<int> landmarks,
+                             int embedOption, QPolygonF previous = QPolygonF());
 
     struct BasicVoronoiGraph{
         struct Cell{
@@ -44,9 +50,28 @@ namespace ExploreProcess{
         QSharedPointer<SynthesisManager> synthManager;
 
         bool isReady;
-        BlendPath() : isReady(false){}
+        BlendPath() : isReady(false), isFilled(false), frameBytes(0), maxFrameBytes(32 << 20){}
+
+        // prepare() may run on a worker, cancel() makes it return at its next stage without becoming ready
+        QAtomicInt isCancelled;
+        void cancel(){ isCancelled.store(1); }
 
         void prepare(Document * document);
         QVector<Thumbnail::QBasicMesh> blend();
+
+        // Synthesized frames by index in scheduler->allGraphs, at most maxFrameBytes of geometry.
+        // fillFrames() runs on a worker outward from the current alpha, blend() shows the closest
+        // cached frame instead of waiting while a frame is being synthesized there
+        void fillFrames(double fromAlpha);
+        void clearFrames();
+        bool isFilled;
+        QMap< int, QVector<Thumbnail::QBasicMesh> > frames;
+        qint64 frameBytes, maxFrameBytes;
+        QMutex framesLock, synthLock;
+
+    protected:
+        int frameIndex(double a) const;
+        QVector<Thumbnail::QBasicMesh> synthesizeFrame(int index);
+        bool insertFrame(int index, const QVector<Thumbnail::QBasicMesh> & parts, bool isEvicting);
     };
 }
@@ -0,0 +1,128 @@
+#pragma once
+#include <QLineF>
+#include <QRectF>
+#include <QVector>
+#include <QVector2D>
+#include <QSet>
+#include <cmath>
+#include <algorithm>
+
+// Uniform grid over 2D segments, each cell lists the segments passing through it
+class SegmentGrid
+{
+public:
+    SegmentGrid() : cols(0), rows(0), cellSize(1){}
+
+    void build(QRectF extent, int numSegments)
+    {
+        // About one segment per cell on average
+        int side = std::min(128, std::max(8, int(std::sqrt(double(numSegments)))));
+        origin = extent.topLeft();
+        cellSize = std::max(extent.width(), extent.height()) / side;
+        if(cellSize <= 0) cellSize = 1;
+        cols = std::max(1, int(std::ceil(extent.width() / cellSize)));
+        rows = std::max(1, int(std::ceil(extent.height() / cellSize)));
+        cells.clear();
+        cells.resize(cols * rows);
+        segments.clear();
+    }
+
+    int insert(QLineF line)
+    {
+        int id = segments.size();
+        segments << line;
+
+        // Walk the cells crossed by the segment
+        double x0 = (line.p1().x() - origin.x()) / cellSize, y0 = (line.p1().y() - origin.y()) / cellSize;
+        double x1 = (line.p2().x() - origin.x()) / cellSize, y1 = (line.p2().y() - origin.y()) / cellSize;
+        int cx = std::floor(x0), cy = std::floor(y0), ex = std::floor(x1), ey = std::floor(y1);
+        double dx = x1 - x0, dy = y1 - y0;
+        int stepX = dx > 0 ? 1 : -1, stepY = dy > 0 ? 1 : -1;
+        double tDeltaX = dx != 0 ? std::abs(1.0 / dx) : HUGE_VAL, tDeltaY = dy != 0 ? std::abs(1.0 / dy) : HUGE_VAL;
+        double tMaxX = dx != 0 ? ((cx + (stepX > 0)) - x0) / dx : HUGE_VAL;
+        double tMaxY = dy != 0 ? ((cy + (stepY > 0)) - y0) / dy : HUGE_VAL;
+
+        int steps = std::abs(ex - cx) + std::abs(ey - cy);
+        for(int i = 0; i <= steps; i++)
+        {
+            auto & cell = cells[clamp(cx, cols) + clamp(cy, rows) * cols];
+            if(cell.isEmpty() || cell.back() != id) cell << id;
+
+            if(tMaxX < tMaxY){ cx += stepX; tMaxX += tDeltaX; }
+            else{ cy += stepY; tMaxY += tDeltaY; }
+        }
+
+        return id;
+    }
+
+    // Up to 'k' closest segments as (distance, id), closest first
+    QVector< QPair<double,int> > nearest(QPointF p, int k) const
+    {
+        QVector< QPair<double,int> > result;
+        if(segments.isEmpty()) return result;
+
+        int px = clamp(std::floor((p.x() - origin.x()) / cellSize), cols);
+        int py = clamp(std::floor((p.y() - origin.y()) / cellSize), rows);
+
+        QSet<int> seen;
+        int maxRing = std::max(cols, rows);
+
+        for(int r = 0; r <= maxRing; r++)
+        {
+            for(int y = py - r; y <= py + r; y++)
+            {
+                if(y < 0 || y >= rows) continue;
+
+                // Only the border of the ring
+                int stride = (y == py - r || y == py + r) ? 1 : std::max(1, 2 * r);
+                for(int x = px - r; x <= px + r; x += stride)
+                {
+                    if(x < 0 || x >= cols) continue;
+
+                    for(int id : cells[x + y * cols])
+                    {
+                        if(seen.contains(id)) continue;
+                        seen.insert(id);
+
+                        QPointF projection;
+                        result << qMakePair(distance(p, segments[id], projection), id);
+                    }
+                }
+            }
+
+            // Segments not seen yet are at least r cells away
+            if(result.size() >= k)
+            {
+                std::partial_sort(result.begin(), result.begin() + k, result.end());
+                result.resize(k);
+                if(result.back().first <= r * cellSize) break;
+            }
+        }
+
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    static double distance(QPointF p, QLineF l, QPointF & projection)
+    {
+        QVector2D v (l.p2() - l.p1());
+        QVector2D w (p - l.p1());
+        auto c1 = QVector2D::dotProduct(w,v);
+        if ( c1 <= 0 ) {projection = l.p1(); return QVector2D(p - l.p1()).length();}
+        auto c2 = QVector2D::dotProduct(v,v);
+        if ( c2 <= c1 ) {projection = l.p2(); return QVector2D(p - l.p2()).length();}
+        auto b = c1 / c2;
+        QVector2D Pb (QVector2D(l.p1()) + b * v);
+        projection = Pb.toPointF();
+        return (QVector2D(p) - Pb).length();
+    }
+
+protected:
+    static int clamp(double i, int n){ return std::min(n - 1, std::max(0, int(i))); }
+
+    int cols, rows;
+    double cellSize;
+    QPointF origin;
+    QVector< QVector<int> > cells;
+    QVector<QLineF> segments;
+};
@@ -53,10 +53,10 @@ void ManualBlendManager::doBlend(QString source_part_name, QString target_name,
 			for (auto id : group){
 				sids << id;
 
-				if (document->datasetCorr[sourceName][id][targetName].empty()){
+				if (!document->corrIndex()->hasMatches(sourceName, id, targetName)){
 					gcorr->setNonCorresSource(id);
 				} else {
-					auto tid = document->datasetCorr[sourceName][id][targetName].front();
+					auto tid = document->corrIndex()->firstMatch(sourceName, id, targetName);
 					if (!tids.contains(tid))
 						tids << tid;
 				}
@@ -216,8 +216,8 @@ void ManualBlendManager::finalizeBlend(QString source_part_name, QString target_
 			nodeMesh->update_vertex_normals();
 			nodeMesh->updateBoundingBox();
 
-			newNode->property["mesh"].setValue(QSharedPointer<SurfaceMeshModel>(nodeMesh));
 			newNode->id = source_part_name;
+			model->setNodeMesh(newNode, QSharedPointer<SurfaceMeshModel>(nodeMesh));
 
 			// Select it
 			model->activeNode = newNode;
@@ -239,8 +239,8 @@ void ManualBlendManager::finalizeBlend(QString source_part_name, QString target_
                 nodeMesh->update_vertex_normals();
                 nodeMesh->updateBoundingBox();
 
-				newNode->property["mesh"].setValue(QSharedPointer<SurfaceMeshModel>(nodeMesh));
 				newNode->id = node_id;
+				model->setNodeMesh(newNode, QSharedPointer<SurfaceMeshModel>(nodeMesh));
             }
         }
 
@@ -319,8 +319,8 @@ void ManualBlendManager::finalizeBlend(QString source_part_name, QString target_
 		// Replace the node
 		auto node_id = n->id;
 		auto newNode = model->replaceNode(node_id, t_node->clone(), true);
-		newNode->property["mesh"].setValue(QSharedPointer<SurfaceMeshModel>(nodeMesh));
 		newNode->id = node_id;
+		model->setNodeMesh(newNode, QSharedPointer<SurfaceMeshModel>(nodeMesh));
 	}
 
 	model->deselectAll();
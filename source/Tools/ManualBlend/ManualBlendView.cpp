@@ -261,7 +261,8 @@ void ManualBlendView::suggestParts(QPointF galleryPos)
 
     QString sourceName = document->firstModelName();
 	QString sourcePart = model->activeNode->id;
-    if (document->datasetCorr[sourceName][sourcePart].empty()){
+    auto targetNames = document->corrIndex()->targets(sourceName, sourcePart);
+    if (targetNames.empty()){
 		((GraphicsScene*)scene())->displayMessage("No correspondence found", 500);
 		return;
 	}
@@ -329,28 +330,19 @@ void ManualBlendView::suggestParts(QPointF galleryPos)
 	QVariantMap sharedData;
 	sharedData["sourcePart"].setValue(sourcePart);
 
-	auto toBasicMesh = [&](opengp::SurfaceMesh::SurfaceMeshModel * m, QColor color){
-		Thumbnail::QBasicMesh mesh;
-		m->update_face_normals();
-		for (auto f : m->faces()){
-			QVector<QVector3D> fp, fn;
-			for (auto vf : m->vertices(f)){
-				auto p = m->vertex_coordinates()[vf];
-				auto n = m->face_normals()[f];
-				fp << QVector3D(p[0], p[1], p[2]);
-				fn << QVector3D(n[0], n[1], n[2]);
-			}
-			mesh.addTri(fp[0], fp[1], fp[2], fn[0], fn[1], fn[2]);
-		}
-		mesh.color = color;
-		return mesh;
-	};
+	pinnedTargets = QSharedPointer<Document::PinnedModels>(new Document::PinnedModels(document, targetNames));
 
-    for (auto targetName : document->datasetCorr[sourceName][sourcePart].keys())
+    for (auto targetName : targetNames)
 	{
 		auto targetModel = document->cacheModel(targetName);
+		if (targetModel == nullptr) continue;
+
+		// Every suggestion from this target shows the same gray parts, their buffers are shared
+		QMap<QString, Thumbnail::QBasicMesh> grayParts;
+		for (auto n : targetModel->nodes)
+			grayParts[n->id] = Thumbnail::toBasicMesh(targetModel->getMesh(n->id), QColor(128,128,128,128));
 
-        for (auto targetPartName : document->datasetCorr[sourceName][sourcePart][targetName])
+        for (auto targetPartName : document->corrIndex()->matches(sourceName, sourcePart, targetName))
 		{
 			auto data = sharedData;
 
@@ -359,14 +351,14 @@ void ManualBlendView::suggestParts(QPointF galleryPos)
 
 			auto targetPartMesh = targetModel->getMesh(targetPartName);
 
-			auto t = gallery->addMeshItem(toBasicMesh(targetPartMesh, Qt::yellow), data);
+			auto t = gallery->addMeshItem(Thumbnail::toBasicMesh(targetPartMesh, Qt::yellow), data);
 
 			t->setCamera(thumb_eye, thumb_pvm);
 
 			// Add remaining parts of target shape
 			for (auto n : targetModel->nodes){
 				if (n->id == targetPartName) continue;
-				t->addAuxMesh(toBasicMesh(targetModel->getMesh(n->id), QColor(128,128,128,128)));
+				t->addAuxMesh(grayParts[n->id]);
 			}
 
 			connect(t, SIGNAL(clicked(Thumbnail *)), SLOT(suggestionClicked(Thumbnail *)));
@@ -9,7 +9,8 @@
 
 #include <Eigen/Core>
 
-class Document;
+#include "Document.h"
+
 class Gallery;
 class Thumbnail;
 
@@ -42,6 +43,9 @@ protected:
     Document * document;
 	Gallery * gallery;
 
+	// Targets of the suggestions stay resident until they are replaced or the view closes
+	QSharedPointer<Document::PinnedModels> pinnedTargets;
+
     // Camera movement
     Eigen::Camera* camera;
     Eigen::Trackball* trackball;
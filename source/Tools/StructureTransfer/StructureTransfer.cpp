@@ -10,6 +10,7 @@
 #include "GraphicsView.h"
 #include "Camera.h"
 #include "Gallery.h"
+#include "GalleryLoader.h"
 
 #include <QGraphicsDropShadowEffect>
 #include <QTimer>
@@ -24,7 +25,7 @@ Q_DECLARE_METATYPE(Array2D_Vector3)
 
 #include "IsotropicRemesher.h"
 
-StructureTransfer::StructureTransfer(Document *document, const QRectF &bounds) : Tool(document), view(nullptr)
+StructureTransfer::StructureTransfer(Document *document, const QRectF &bounds) : Tool(document), view(nullptr), galleryLoader(nullptr)
 {
     connect(this, SIGNAL(boundsChanged()), SLOT(resizeViews()));
 
@@ -115,6 +116,8 @@ void StructureTransfer::init()
 					}
 				}
 
+				sourceModel->invalidateMeshes();
+
 				((GraphicsScene*)scene())->displayMessage(QString("External mesher done. OK = %1").arg(isGood));
 
 				qApp->restoreOverrideCursor();
@@ -129,6 +132,8 @@ void StructureTransfer::init()
 				Remesh::IsotropicRemesher mesher(m);
 				mesher.apply();
 			}
+
+			sourceModel->invalidateMeshes();
 		});
 		
         connect(document, &Document::categoryAnalysisDone, [=](){
@@ -149,46 +154,13 @@ void StructureTransfer::init()
             cameraMatrix = QMatrix4x4(p.data()) * QMatrix4x4(v.data());
             QVector3D cameraPos(view->camera->position().x(),view->camera->position().y(),view->camera->position().z());
 
-            // From surface mesh to basic mesh
-            auto toBasicMesh = [&](opengp::SurfaceMesh::SurfaceMeshModel * m, QColor color){
-                Thumbnail::QBasicMesh mesh;
-                m->update_face_normals();
-                for (auto f : m->faces()){
-                    QVector<QVector3D> fp, fn;
-                    for (auto vf : m->vertices(f)){
-                        auto p = m->vertex_coordinates()[vf];
-                        auto n = m->face_normals()[f];
-                        fp << QVector3D(p[0], p[1], p[2]);
-                        fn << QVector3D(n[0], n[1], n[2]);
-                    }
-                    mesh.addTri(fp[0], fp[1], fp[2], fn[0], fn[1], fn[2]);
-                }
-                mesh.color = color;
-                return mesh;
-            };
-
-            auto catModels = document->categories[document->currentCategory].toStringList();
-            for (auto targetName : catModels)
-            {
-                auto targetModel = document->cacheModel(targetName);
-                auto t = gallery->addTextItem(targetName);
-
-                QVariantMap data = t->data;
-                data["targetName"].setValue(targetName);
-                t->setData(data);
-
-                t->setCamera(cameraPos, cameraMatrix);
-                t->setFlag(QGraphicsItem::ItemIsSelectable);
-
-                // Add parts of target shape
-                for (auto n : targetModel->nodes){
-                    t->addAuxMesh(toBasicMesh(targetModel->getMesh(n->id), n->vis_property["color"].value<QColor>()));
-                }
-
+            // Shapes are loaded and converted in the background, thumbnails fill in as they are ready
+            if (galleryLoader) galleryLoader->discard();
+            galleryLoader = new GalleryLoader(document, gallery, cameraPos, cameraMatrix, this);
+            connect(galleryLoader, &GalleryLoader::thumbnailAdded, [=](Thumbnail * t){
                 QObject::connect(t, SIGNAL(doubleClicked(Thumbnail*)), this, SLOT(thumbnailSelected(Thumbnail*)));
-
-                scene()->update(t->sceneBoundingRect());
-            }
+            });
+            galleryLoader->load(document->categories[document->currentCategory].toStringList());
 
             scene()->update(this->sceneBoundingRect());
             QTimer::singleShot(500, [=]{ gallery->update(); });
@@ -214,8 +186,11 @@ void StructureTransfer::thumbnailSelected(Thumbnail * t)
     auto sourceName = document->firstModelName();
     auto targetName = data["targetName"].toString();
 
+    pinnedTarget = QSharedPointer<Document::PinnedModels>(new Document::PinnedModels(document, QStringList() << targetName));
+
     auto sourceModel = document->getModel(sourceName);
     auto targetModel = document->cacheModel(targetName);
+    if (sourceModel == nullptr || targetModel == nullptr) return;
 
 	if (!sourceModel->ShapeGraph::property.contains("origPoints"))
 		sourceModel->ShapeGraph::property["origPoints"].setValue(sourceModel->getAllControlPoints());
@@ -224,7 +199,7 @@ void StructureTransfer::thumbnailSelected(Thumbnail * t)
 
     ShapeGeometry::encodeGeometry(sourceModel);
 
-    if(document->datasetCorr.contains(sourceName))
+    if(document->corrIndex()->contains(sourceName))
     {
         auto shapeA = QSharedPointer<Structure::ShapeGraph>(new Structure::ShapeGraph(*sourceModel));
         auto shapeB = QSharedPointer<Structure::ShapeGraph>(new Structure::ShapeGraph(*targetModel));
@@ -236,10 +211,10 @@ void StructureTransfer::thumbnailSelected(Thumbnail * t)
         {
             n->vis_property["isHidden"].setValue(false);
 
-            if(document->datasetCorr[sourceName][n->id].contains(targetName))
+            if(document->corrIndex()->hasMatches(sourceName, n->id, targetName))
             {
                 la << n->id;
-                lb << document->datasetCorr[sourceName][n->id][targetName].front();
+                lb << document->corrIndex()->firstMatch(sourceName, n->id, targetName);
             }
             else
             {
@@ -320,6 +295,7 @@ void StructureTransfer::thumbnailSelected(Thumbnail * t)
     }
 
     ShapeGeometry::decodeGeometry(sourceModel);
+    sourceModel->invalidateMeshes();
 
 	scene()->update(sceneBoundingRect());
 }
@@ -1,9 +1,11 @@
 #pragma once
 #include "Tool.h"
+#include "Document.h"
 
 class StructureTransferView;
 namespace Ui{ class StructureTransferWidget; }
 class Gallery;
+class GalleryLoader;
 class Thumbnail;
 
 class StructureTransfer : public Tool
@@ -17,9 +19,13 @@ public:
 protected:
     StructureTransferView* view;
     Gallery* gallery;
+    GalleryLoader* galleryLoader;
     Ui::StructureTransferWidget* widget;
     QGraphicsProxyWidget* widgetProxy;
 
+    // The selected target stays resident until another one is selected or the tool closes
+    QSharedPointer<Document::PinnedModels> pinnedTarget;
+
 public slots:
     void resizeViews();
     void thumbnailSelected(Thumbnail *t);
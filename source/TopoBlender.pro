@@ -1,4 +1,4 @@
-QT          += core gui opengl widgets xml
+QT          += core gui opengl widgets xml concurrent
 
 TARGET      = TopoBlender
 TEMPLATE    = app
@@ -16,12 +16,23 @@ SOURCES +=  main.cpp\
             Tool.cpp \
             Viewer.cpp \
             Document.cpp \
+            DocumentGui.cpp \
             DocumentAnalyzeWorker.cpp \
+            PairwiseCache.cpp \
+            ThumbnailCache.cpp \
+            CorrespondenceFile.cpp \
+            CorrespondenceIndex.cpp \
+            ModelCache.cpp \
             Model.cpp \
+            ModelDraw.cpp \
+            BVH.cpp \
             ModelMesher.cpp \
             ModelConnector.cpp \
+            BasicMesh.cpp \
             Thumbnail.cpp \
+            OffscreenRenderer.cpp \
             Gallery.cpp \
+            GalleryLoader.cpp \
 # Sketch tool
             Tools/Sketch/Sketch.cpp \
             Tools/Sketch/SketchView.cpp \
@@ -33,6 +44,7 @@ SOURCES +=  main.cpp\
             Tools/ManualBlend/ManualBlendManager.cpp \
 # Auto blend tool
             Tools/AutoBlend/AutoBlend.cpp \
+            Tools/AutoBlend/BlendJob.cpp \
 # Structure transfer tool
             Tools/StructureTransfer/StructureTransfer.cpp \
             Tools/StructureTransfer/StructureTransferView.cpp \
@@ -40,10 +52,12 @@ SOURCES +=  main.cpp\
             Tools/Explore/Explore.cpp \
             Tools/Explore/ExploreProcess.cpp \
             Tools/Explore/ExploreLiveView.cpp \
+            Tools/Explore/Embedding.cpp \
     ResolveCorrespondence.cpp
 
 HEADERS  += mainwindow.h \
             GeometryHelper.h \
+            VertexWelder.h \
             GraphicsView.h \
             GraphicsScene.h \
             ModifiersPanel.h \
@@ -52,11 +66,20 @@ HEADERS  += mainwindow.h \
             Camera.h \
             Document.h \
             DocumentAnalyzeWorker.h \
+            PairwiseCache.h \
+            ThumbnailCache.h \
+            CorrespondenceFile.h \
+            CorrespondenceIndex.h \
+            ModelCache.h \
             Model.h \
+            BVH.h \
             ModelMesher.h \
             ModelConnector.h \
+            BasicMesh.h \
             Thumbnail.h \
+            OffscreenRenderer.h \
             Gallery.h \
+            GalleryLoader.h \
 # Sketch tool
             Tools/Sketch/Sketch.h \
             Tools/Sketch/SketchView.h \
@@ -68,6 +91,7 @@ HEADERS  += mainwindow.h \
             Tools/ManualBlend/ManualBlendManager.h \
 # Auto blend tool
             Tools/AutoBlend/AutoBlend.h \
+            Tools/AutoBlend/BlendJob.h \
 # Structure transfer tool
             Tools/StructureTransfer/StructureTransfer.h \
             Tools/StructureTransfer/StructureTransferView.h \
@@ -75,6 +99,8 @@ HEADERS  += mainwindow.h \
             Tools/Explore/Explore.h \
             Tools/Explore/ExploreProcess.h \
             Tools/Explore/ExploreLiveView.h \
+            Tools/Explore/SegmentGrid.h \
+            Tools/Explore/Embedding.h \
     ResolveCorrespondence.h
 
 # Qt UI files
@@ -0,0 +1,91 @@
+# QtGui only for its value types (QColor, QVector3D, QImage), no windowing or GL
+QT          += core gui xml concurrent
+
+TARGET      = TopoBlenderCLI
+TEMPLATE    = app
+DESTDIR     = $$PWD/../bin
+CONFIG      += console
+CONFIG      -= app_bundle
+
+CONFIG(debug, debug|release) {TARGET = TopoBlenderCLID}
+
+INCLUDEPATH += . external
+
+# Same document and blending code as the GUI, without the tools, their views and the drawing code
+SOURCES +=  cli/main.cpp \
+            Document.cpp \
+            DocumentAnalyzeWorker.cpp \
+            PairwiseCache.cpp \
+            ThumbnailCache.cpp \
+            CorrespondenceFile.cpp \
+            CorrespondenceIndex.cpp \
+            ModelCache.cpp \
+            Model.cpp \
+            BVH.cpp \
+            ModelMesher.cpp \
+            ModelConnector.cpp \
+            BasicMesh.cpp \
+            Tools/AutoBlend/BlendJob.cpp \
+            ResolveCorrespondence.cpp
+
+HEADERS  += GeometryHelper.h \
+            Document.h \
+            DocumentAnalyzeWorker.h \
+            PairwiseCache.h \
+            ThumbnailCache.h \
+            CorrespondenceFile.h \
+            CorrespondenceIndex.h \
+            ModelCache.h \
+            Model.h \
+            BVH.h \
+            ModelMesher.h \
+            ModelConnector.h \
+            BasicMesh.h \
+            Tools/AutoBlend/BlendJob.h \
+            ResolveCorrespondence.h
+
+win32{
+    # Eigen 3.2.5 introduced some new warnings
+    QMAKE_CXXFLAGS *= /wd4522
+}
+
+# C++11 support on linux
+linux-g++{ CONFIG += c++11 warn_off }
+
+# OpenMP
+win32{
+    QMAKE_CXXFLAGS *= /openmp
+}
+unix:!mac{
+    QMAKE_CXXFLAGS *= -fopenmp
+    LIBS += -lgomp
+}
+
+### GeoTopo Libraries
+
+# Build flag
+CONFIG(debug, debug|release) {CFG = debug} else {CFG = release}
+
+# GeoTopo library
+LIBS += -L$$PWD/../../GeoTopo/source/GeoTopoLib/lib/$$CFG -lGeoTopoLib
+INCLUDEPATH += ../../GeoTopo/source/GeoTopoLib
+
+# StructureGraph library
+LIBS += -L$$PWD/../../GeoTopo/source/StructureGraphLib/lib/$$CFG -lStructureGraphLib
+INCLUDEPATH += ../../GeoTopo/source/StructureGraphLib
+
+# Surface Reconstruction library
+LIBS += -L$$PWD/../../GeoTopo/source/Reconstruction/lib/$$CFG -lReconstruction
+INCLUDEPATH += ../../GeoTopo/source/Reconstruction
+
+# Surface mesh library
+LIBS += -L$$PWD/../../GeoTopo/source/external/SurfaceMesh/lib/$$CFG -lSurfaceMesh
+INCLUDEPATH += ../../GeoTopo/source/external/SurfaceMesh ../../GeoTopo/source/external/SurfaceMesh/surface_mesh
+
+# NURBS library
+LIBS += -L$$PWD/../../GeoTopo/source/NURBS/lib/$$CFG -lNURBS
+INCLUDEPATH += ../../GeoTopo/source/NURBS
+
+### Other libraries
+# SDF library
+INCLUDEPATH += external/SDFGen
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+
+// Welds points that lie within 'tolerance' of an earlier point, in expected linear time.
+// Points are hashed into cells twice as wide as the tolerance, so each query looks at eight cells at most.
+// 'xrefs' maps every input point to its index in the returned list, a welded point keeps its first position.
+template<class Vector3>
+std::vector<Vector3> weldPoints(const std::vector<Vector3> & points, std::vector<int> & xrefs, double tolerance)
+{
+    std::vector<Vector3> welded;
+    xrefs.assign(points.size(), -1);
+    if (points.empty()) return welded;
+
+    // Exact matches only need a shared cell
+    double cellSize = tolerance > 0 ? 2.0 * tolerance : 1.0;
+    double toleranceSq = tolerance > 0 ? tolerance * tolerance : 0;
+
+    auto cellKey = [](std::int64_t x, std::int64_t y, std::int64_t z){
+        const std::uint64_t mask = (1u << 21) - 1;
+        return (std::uint64_t(x) & mask) | ((std::uint64_t(y) & mask) << 21) | ((std::uint64_t(z) & mask) << 42);
+    };
+
+    // Each cell holds the head of a list of welded points, threaded through 'next'
+    std::unordered_map<std::uint64_t, int> cells;
+    cells.reserve(points.size());
+    std::vector<int> next;
+    next.reserve(points.size());
+    welded.reserve(points.size());
+
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        const Vector3 & p = points[i];
+
+        std::int64_t cell[3], side[3];
+        for (int axis = 0; axis < 3; axis++){
+            double f = p[axis] / cellSize;
+            double c = std::floor(f);
+            cell[axis] = std::int64_t(c);
+
+            // Neighbouring cell on the side the tolerance reaches into, if any
+            double frac = (f - c) * cellSize;
+            side[axis] = (frac < tolerance) ? -1 : ((cellSize - frac) < tolerance ? 1 : 0);
+        }
+
+        int match = -1;
+        for (int corner = 0; corner < 8 && match < 0; corner++)
+        {
+            std::int64_t c[3];
+            bool isValid = true;
+            for (int axis = 0; axis < 3; axis++){
+                bool isOffset = (corner >> axis) & 1;
+                if (isOffset && side[axis] == 0) isValid = false;
+                c[axis] = cell[axis] + (isOffset ? side[axis] : 0);
+            }
+            if (!isValid) continue;
+
+            auto found = cells.find(cellKey(c[0], c[1], c[2]));
+            if (found == cells.end()) continue;
+
+            for (int w = found->second; w >= 0; w = next[w]){
+                double distSq = 0;
+                for (int axis = 0; axis < 3; axis++){
+                    double d = p[axis] - welded[w][axis];
+                    distSq += d * d;
+                }
+                if (distSq <= toleranceSq){
+                    match = w;
+                    break;
+                }
+            }
+        }
+
+        if (match < 0)
+        {
+            match = int(welded.size());
+            welded.push_back(p);
+
+            auto & head = cells.insert(std::make_pair(cellKey(cell[0], cell[1], cell[2]), -1)).first->second;
+            next.push_back(head);
+            head = match;
+        }
+
+        xrefs[i] = match;
+    }
+
+    return welded;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <QString>
+#include <QVector>
+#include <QVector3D>
+#include <QVariantMap>
+#include <QSharedPointer>
+#include <QElapsedTimer>
+#include <Eigen/Core>
+
+class Model;
+namespace opengp{ namespace SurfaceMesh{ class SurfaceMeshModel; } }
+
+namespace Benchmarks{
+
+typedef Eigen::Vector3d Vector3;
+
+// Triangle soup split into parts, the kind of geometry a shape graph holds
+struct Part{
+    std::vector<Vector3> points;
+    std::vector<Eigen::Vector3i> triangles;
+};
+
+// Spheres laid out on a grid, 'facesPerPart' is rounded to the closest tessellation
+std::vector<Part> makeSphereParts(int numParts, int facesPerPart);
+
+// Closed tori without the collapsed pole triangles of the spheres, for code that rebuilds connectivity
+std::vector<Part> makeTorusParts(int numParts, int facesPerPart);
+
+// Parts as one surface mesh, 'isSoup' gives every triangle its own three vertices
+opengp::SurfaceMesh::SurfaceMeshModel * makeMesh(const std::vector<Part> & parts, bool isSoup);
+
+// Sketch input of synthetic parts: points along a helix for curves, a corner and its two edges for sheets
+QVector<QVector3D> helix(QVector3D base, double radius, double height, double turns);
+QVector<QVector3D> rectangle(QVector3D corner, QVector3D u, QVector3D v);
+
+// Shapes made of curves and sheets the way the sketch tool builds them: "chair", "table" and "shelf"
+QSharedPointer<Model> makeShape(QString name);
+QSharedPointer<Model> makeGridShape(int numParts);
+
+// The synthetic shapes, then the shapes of the dataset folder when one is set
+struct Shape{
+    QString name;
+    QSharedPointer<Model> model;
+};
+QVector<Shape> shapeSet();
+void setDatasetFolder(QString folder);
+
+// Milliseconds per call of 'f', best of 'repeats'
+template<class Function>
+double timeIt(Function f, int repeats = 3)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < repeats; i++){
+        QElapsedTimer timer;
+        timer.start();
+        f();
+        best = std::min(best, timer.nsecsElapsed() * 1e-6);
+    }
+    return best;
+}
+
+// Adds one case to the JSON report, 'parameters' identify it across runs and 'results' hold times in ms and counts
+void record(QString benchmark, QVariantMap parameters, QVariantMap results);
+
+// Correctness checks run along the timings, a failed one makes the suite exit with an error
+void expect(bool condition, QString what);
+
+void picking();
+void weld();
+void levelset();
+void merge();
+void mesher();
+void select();
+void connector();
+void embed();
+void remesh();
+
+}
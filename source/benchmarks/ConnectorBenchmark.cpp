@@ -0,0 +1,59 @@
+#include "Benchmarks.h"
+#include "Model.h"
+#include "ModelConnector.h"
+
+#include <iostream>
+
+using namespace Benchmarks;
+
+// Edges between touching parts. The first pass builds the collision models, later passes
+// reuse them and skip the pairs that are already connected
+void Benchmarks::connector()
+{
+    std::cout << "connector" << std::endl;
+
+    for (auto shape : shapeSet())
+    {
+        auto model = shape.model.data();
+        int numEdges = model->edges.size();
+
+        double firstTime = timeIt([&]{ ModelConnector connector(model); }, 1);
+        int addedEdges = model->edges.size() - numEdges;
+
+        double repeatTime = timeIt([&]{ ModelConnector connector(model); });
+
+        std::cout << "  " << qPrintable(shape.name)
+                  << "  parts " << model->nodes.size()
+                  << "  first " << firstTime << " ms"
+                  << "  repeat " << repeatTime << " ms"
+                  << "  edges " << addedEdges << std::endl;
+
+        record("connector", QVariantMap{ {"shape", shape.name}, {"parts", int(model->nodes.size())} },
+               QVariantMap{ {"first", firstTime}, {"repeat", repeatTime}, {"edges", addedEdges} });
+    }
+
+    // Thickening a part keeps its connectivity, the connector must test the new surface
+    {
+        QSharedPointer<Model> model(new Model);
+        for (double x : {0.0, 0.3}){
+            QVector<QVector3D> points;
+            for (int i = 0; i <= 10; i++) points << QVector3D(x, 0, i * 0.1);
+            model->createCurveFromPoints(points);
+        }
+        auto part = model->nodes.front();
+
+        { ModelConnector connector(model.data()); }
+        bool isThinConnected = !model->edges.isEmpty();
+
+        model->activeNode = part;
+        model->generateSurface(0.3);
+        { ModelConnector connector(model.data()); }
+        bool isThickConnected = !model->edges.isEmpty();
+
+        bool isCurrent = !isThinConnected && isThickConnected;
+        std::cout << "  regenerated part " << (isCurrent ? "connected" : "STALE") << std::endl;
+
+        record("connector", QVariantMap{ {"shape", "regenerated"} }, QVariantMap{ {"isCurrent", isCurrent} });
+        expect(isCurrent, "connector: a regenerated part is tested with its new surface");
+    }
+}
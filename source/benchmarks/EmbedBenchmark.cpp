@@ -0,0 +1,61 @@
+#include "Benchmarks.h"
+#include "Tools/Explore/ExploreProcess.h"
+#include "Tools/Explore/Embedding.h"
+
+#include <QPolygonF>
+#include <iostream>
+#include <random>
+
+using namespace Benchmarks;
+
+// Layout of the explore tool from all pairwise distances, cold and warm started from the last layout
+void Benchmarks::embed()
+{
+    std::cout << "embed" << std::endl;
+
+    for (int numShapes : { 50, 200, 800 })
+    {
+        // Shapes as points of a feature space with a few clusters, as categories tend to be
+        std::mt19937 rng(0);
+        std::normal_distribution<double> normal(0, 1);
+        std::vector<Eigen::VectorXd> features(numShapes);
+        for (int i = 0; i < numShapes; i++){
+            features[i] = Eigen::VectorXd::Constant(8, 3.0 * (i % 5));
+            for (int d = 0; d < 8; d++) features[i][d] += normal(rng);
+        }
+
+        QMap<int, QMap<int, double> > distMatrix;
+        Eigen::MatrixXd D(numShapes, numShapes);
+        for (int i = 0; i < numShapes; i++){
+            for (int j = 0; j < numShapes; j++){
+                D(i,j) = (features[i] - features[j]).norm();
+                distMatrix[i][j] = D(i,j);
+            }
+        }
+
+        auto stress = [&](const QPolygonF & layout){
+            Embedding::Points X(layout.size(), 2);
+            for (int i = 0; i < layout.size(); i++) X.row(i) << layout[i].x(), layout[i].y();
+            return Embedding::stress(D, X);
+        };
+
+        QStringList methods;
+        methods << "smacof" << "ucf";
+
+        for (int option = 0; option < methods.size(); option++)
+        {
+            QPolygonF layout, warmLayout;
+            double coldTime = timeIt([&]{ layout = ExploreProcess::embed(distMatrix, option); }, 1);
+            double warmTime = timeIt([&]{ warmLayout = ExploreProcess::embed(distMatrix, option, layout); }, 1);
+
+            std::cout << "  shapes " << numShapes << "  " << qPrintable(methods[option])
+                      << "  cold " << coldTime << " ms"
+                      << "  warm " << warmTime << " ms"
+                      << "  stress " << stress(layout) << " / " << stress(warmLayout) << std::endl;
+
+            record("embed", QVariantMap{ {"shapes", numShapes}, {"method", methods[option]} },
+                   QVariantMap{ {"cold", coldTime}, {"warm", warmTime},
+                                {"coldStress", stress(layout)}, {"warmStress", stress(warmLayout)} });
+        }
+    }
+}
@@ -0,0 +1,213 @@
+#include "Benchmarks.h"
+#include "Model.h"
+#include "Document.h"
+#include "SurfaceMeshModel.h"
+
+#include <cmath>
+
+using namespace opengp::SurfaceMesh;
+
+static QString datasetFolder;
+
+void Benchmarks::setDatasetFolder(QString folder)
+{
+    datasetFolder = folder;
+}
+
+std::vector<Benchmarks::Part> Benchmarks::makeSphereParts(int numParts, int facesPerPart)
+{
+    int rings = std::max(3, int(std::sqrt(facesPerPart / 2.0)));
+    int sectors = rings;
+
+    int grid = std::ceil(std::sqrt(double(numParts)));
+
+    std::vector<Part> parts(numParts);
+    for (int p = 0; p < numParts; p++)
+    {
+        auto & part = parts[p];
+        Vector3 center(2.5 * (p % grid), 2.5 * (p / grid), 0);
+
+        for (int r = 0; r <= rings; r++){
+            double theta = M_PI * r / rings;
+            for (int s = 0; s < sectors; s++){
+                double phi = 2 * M_PI * s / sectors;
+                part.points.push_back(center + Vector3(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta)));
+            }
+        }
+
+        for (int r = 0; r < rings; r++){
+            for (int s = 0; s < sectors; s++){
+                int a = r * sectors + s, b = r * sectors + (s + 1) % sectors;
+                int c = a + sectors, d = b + sectors;
+                part.triangles.push_back(Eigen::Vector3i(a, c, b));
+                part.triangles.push_back(Eigen::Vector3i(b, c, d));
+            }
+        }
+    }
+
+    return parts;
+}
+
+std::vector<Benchmarks::Part> Benchmarks::makeTorusParts(int numParts, int facesPerPart)
+{
+    int rings = std::max(6, int(std::sqrt(double(facesPerPart))));
+    int sectors = std::max(3, facesPerPart / (2 * rings));
+
+    int grid = std::ceil(std::sqrt(double(numParts)));
+
+    std::vector<Part> parts(numParts);
+    for (int p = 0; p < numParts; p++)
+    {
+        auto & part = parts[p];
+        Vector3 center(2.5 * (p % grid), 2.5 * (p / grid), 0);
+
+        for (int r = 0; r < rings; r++){
+            double theta = 2 * M_PI * r / rings;
+            for (int s = 0; s < sectors; s++){
+                double phi = 2 * M_PI * s / sectors;
+                double radius = 0.8 + 0.3 * cos(phi);
+                part.points.push_back(center + Vector3(radius * cos(theta), radius * sin(theta), 0.3 * sin(phi)));
+            }
+        }
+
+        for (int r = 0; r < rings; r++){
+            for (int s = 0; s < sectors; s++){
+                int r1 = (r + 1) % rings, s1 = (s + 1) % sectors;
+                int a = r * sectors + s, b = r * sectors + s1;
+                int c = r1 * sectors + s, d = r1 * sectors + s1;
+                part.triangles.push_back(Eigen::Vector3i(a, c, b));
+                part.triangles.push_back(Eigen::Vector3i(b, c, d));
+            }
+        }
+    }
+
+    return parts;
+}
+
+SurfaceMeshModel * Benchmarks::makeMesh(const std::vector<Part> & parts, bool isSoup)
+{
+    auto mesh = new SurfaceMeshModel();
+
+    for (auto & part : parts)
+    {
+        int offset = mesh->n_vertices();
+
+        if (!isSoup) for (auto & p : part.points) mesh->add_vertex(p);
+
+        for (auto & t : part.triangles)
+        {
+            std::vector<SurfaceMeshModel::Vertex> face;
+            for (int i = 0; i < 3; i++){
+                if (isSoup) face.push_back(mesh->add_vertex(part.points[t[i]]));
+                else face.push_back(SurfaceMeshModel::Vertex(offset + t[i]));
+            }
+            mesh->add_face(face);
+        }
+    }
+
+    mesh->updateBoundingBox();
+    return mesh;
+}
+
+QVector<QVector3D> Benchmarks::helix(QVector3D base, double radius, double height, double turns)
+{
+    QVector<QVector3D> points;
+    int numPoints = 40;
+    for (int i = 0; i < numPoints; i++){
+        double t = double(i) / (numPoints - 1);
+        double angle = 2 * M_PI * turns * t;
+        points << base + QVector3D(radius * cos(angle), radius * sin(angle), height * t);
+    }
+    return points;
+}
+
+QVector<QVector3D> Benchmarks::rectangle(QVector3D corner, QVector3D u, QVector3D v)
+{
+    // The corner first, then its two neighbours, as Model::createSheetFromPoints reads them
+    return QVector<QVector3D>() << corner << corner - v << corner - u;
+}
+
+QSharedPointer<Model> Benchmarks::makeShape(QString name)
+{
+    auto model = QSharedPointer<Model>(new Model());
+
+    auto addCurve = [&](QVector<QVector3D> points){ model->createCurveFromPoints(points); };
+    auto addSheet = [&](QVector<QVector3D> points){ model->createSheetFromPoints(points); };
+
+    QVector3D x(1,0,0), y(0,1,0), z(0,0,1);
+
+    if (name == "chair")
+    {
+        for (auto corner : { QVector3D(0,0,0), QVector3D(0.8,0,0), QVector3D(0,0.8,0), QVector3D(0.8,0.8,0) })
+            addCurve(helix(corner, 0.02, 0.9, 0.25));
+        addSheet(rectangle(QVector3D(0.9,0.9,0.9), x, y));
+        addSheet(rectangle(QVector3D(0.9,0.85,1.8), x, z * 0.85));
+        addCurve(helix(QVector3D(0,0.4,1.1), 0.05, 0.4, 0.5));
+        addCurve(helix(QVector3D(0.8,0.4,1.1), 0.05, 0.4, 0.5));
+    }
+
+    if (name == "table")
+    {
+        for (auto corner : { QVector3D(0,0,0), QVector3D(1.6,0,0), QVector3D(0,0.8,0), QVector3D(1.6,0.8,0) })
+            addCurve(helix(corner, 0.1, 1.0, 1.0));
+        addSheet(rectangle(QVector3D(1.7,0.9,1.0), x * 1.8, y));
+        addSheet(rectangle(QVector3D(1.6,0.8,0.3), x * 1.6, y * 0.8));
+    }
+
+    if (name == "shelf")
+    {
+        for (int level = 0; level < 5; level++)
+            addSheet(rectangle(QVector3D(1,0.4,0.45 * level), x, y * 0.4));
+        addSheet(rectangle(QVector3D(0,0.4,1.8), y * 0.4, z * 1.8));
+        addSheet(rectangle(QVector3D(1,0.4,1.8), y * 0.4, z * 1.8));
+        addCurve(helix(QVector3D(0.5,0,0), 0.3, 1.8, 3.0));
+    }
+
+    return model;
+}
+
+QSharedPointer<Model> Benchmarks::makeGridShape(int numParts)
+{
+    auto model = QSharedPointer<Model>(new Model());
+
+    // Alternating curves and sheets, neighbours close enough to be connected
+    int grid = std::ceil(std::sqrt(double(numParts)));
+    for (int p = 0; p < numParts; p++)
+    {
+        QVector3D base(0.6 * (p % grid), 0.6 * (p / grid), 0);
+        if (p % 2 == 0){
+            auto points = helix(base, 0.1, 0.5, 1.0);
+            model->createCurveFromPoints(points);
+        }
+        else{
+            auto points = rectangle(base + QVector3D(0.25,0.25,0.5), QVector3D(0.5,0,0), QVector3D(0,0.5,0));
+            model->createSheetFromPoints(points);
+        }
+    }
+
+    return model;
+}
+
+QVector<Benchmarks::Shape> Benchmarks::shapeSet()
+{
+    QVector<Shape> shapes;
+    for (QString name : { "chair", "table", "shelf" }) shapes << Shape{ name, makeShape(name) };
+    shapes << Shape{ "grid64", makeGridShape(64) };
+
+    // Real shapes when a dataset is given
+    if (!datasetFolder.isEmpty())
+    {
+        Document document;
+        if (document.loadDataset(datasetFolder))
+        {
+            for (auto name : document.dataset.keys())
+            {
+                auto model = QSharedPointer<Model>(new Model());
+                if (model->loadFromFile(document.dataset[name]["graphFile"].toString()))
+                    shapes << Shape{ name, model };
+            }
+        }
+    }
+
+    return shapes;
+}
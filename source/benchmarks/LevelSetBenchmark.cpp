@@ -0,0 +1,59 @@
+#include "Benchmarks.h"
+#include "makelevelset3.h"
+#include "marchingcubes.h"
+
+#include <iostream>
+#include <cmath>
+
+using namespace Benchmarks;
+
+// Offset surface of a sphere the way ModelMesher::generateOffsetSurface builds one
+void Benchmarks::levelset()
+{
+    std::cout << "levelset" << std::endl;
+
+    auto part = makeSphereParts(1, 2000).front();
+
+    std::vector<SDFGen::Vec3f> vertList;
+    std::vector<SDFGen::Vec3ui> faceList;
+    for (auto & p : part.points) vertList.push_back(SDFGen::Vec3f(p[0], p[1], p[2]));
+    for (auto & t : part.triangles) faceList.push_back(SDFGen::Vec3ui(t[0], t[1], t[2]));
+
+    double offset = 0.1;
+
+    for (int gridSize : { 32, 64, 128 })
+    {
+        float dx = 3.0f / gridSize;
+        SDFGen::Vec3f origin(-1.5f, -1.5f, -1.5f);
+
+        Array3f serialGrid, parallelGrid;
+        double serialTime = timeIt([&]{
+            SDFGen::make_level_set3(faceList, vertList, origin, dx, gridSize, gridSize, gridSize, serialGrid, false, offset * 2.0);
+        }, 1);
+        double parallelTime = timeIt([&]{
+            SDFGen::make_level_set3_parallel(faceList, vertList, origin, dx, gridSize, gridSize, gridSize, parallelGrid, false, offset * 2.0);
+        });
+
+        float maxDifference = 0;
+        for (size_t i = 0; i < serialGrid.a.size(); i++)
+            maxDifference = std::max(maxDifference, std::abs(serialGrid.a[i] - parallelGrid.a[i]));
+
+        // marchIndexed is the march the mesher runs, march() itself is not safe to run threaded
+        size_t numTriangles = 0, numVertices = 0;
+        double marchTime = timeIt([&]{
+            auto mesh = marchIndexed(&parallelGrid.a[0], gridSize, gridSize, gridSize, offset);
+            numTriangles = mesh.triangles.size() / 3;
+            numVertices = mesh.vertices.size();
+        });
+
+        std::cout << "  grid " << gridSize
+                  << "  level set " << serialTime << " ms"
+                  << "  parallel " << parallelTime << " ms"
+                  << "  march " << marchTime << " ms"
+                  << "  triangles " << numTriangles << std::endl;
+
+        record("levelset", QVariantMap{ {"grid", gridSize}, {"faces", int(faceList.size())} },
+               QVariantMap{ {"levelSet", serialTime}, {"levelSetParallel", parallelTime}, {"maxDifference", maxDifference},
+                            {"march", marchTime}, {"triangles", int(numTriangles)}, {"vertices", int(numVertices)} });
+    }
+}
@@ -0,0 +1,36 @@
+#include "Benchmarks.h"
+#include "SurfaceMeshModel.h"
+#include "GeometryHelper.h"
+
+#include <iostream>
+
+using namespace Benchmarks;
+using namespace opengp::SurfaceMesh;
+
+void Benchmarks::merge()
+{
+    std::cout << "merge" << std::endl;
+
+    for (int facesPerPart : { 2000, 20000, 100000 })
+    {
+        auto parts = makeTorusParts(4, facesPerPart);
+
+        // Merging rebuilds the mesh in place, every run starts from its own soup
+        int repeats = 3, run = 0;
+        std::vector< QSharedPointer<SurfaceMeshModel> > soups;
+        for (int i = 0; i < repeats; i++) soups.push_back(QSharedPointer<SurfaceMeshModel>(makeMesh(parts, true)));
+
+        int numFaces = soups.front()->n_faces(), numSoupVertices = soups.front()->n_vertices();
+
+        double mergeTime = timeIt([&]{ meregeVertices<Vector3>(soups[run++].data(), 1e-6); }, repeats);
+
+        int numVertices = soups.front()->n_vertices();
+
+        std::cout << "  faces " << numFaces
+                  << "  merge " << mergeTime << " ms"
+                  << "  vertices " << numSoupVertices << " -> " << numVertices << std::endl;
+
+        record("merge", QVariantMap{ {"faces", numFaces} },
+               QVariantMap{ {"merge", mergeTime}, {"soupVertices", numSoupVertices}, {"vertices", numVertices} });
+    }
+}
@@ -0,0 +1,57 @@
+#include "Benchmarks.h"
+#include "Model.h"
+#include "ModelMesher.h"
+
+#include <iostream>
+
+using namespace Benchmarks;
+
+static int countFaces(Model * model)
+{
+    int numFaces = 0;
+    for (auto n : model->nodes){
+        auto mesh = model->getMesh(n->id);
+        if (mesh) numFaces += mesh->n_faces();
+    }
+    return numFaces;
+}
+
+// Surfaces of every part of a shape, as the sketch tool makes them one part at a time
+void Benchmarks::mesher()
+{
+    std::cout << "mesher" << std::endl;
+
+    double offset = 0.025;
+
+    for (auto shape : shapeSet())
+    {
+        auto model = shape.model.data();
+        ModelMesher mesher(model);
+
+        int numCurves = 0, numSheets = 0;
+        for (auto n : model->nodes){
+            if (n->type() == Structure::CURVE) numCurves++;
+            if (n->type() == Structure::SHEET) numSheets++;
+        }
+
+        double regularTime = timeIt([&]{
+            for (auto n : model->nodes){ model->activeNode = n; mesher.generateRegularSurface(offset); }
+        });
+        int regularFaces = countFaces(model);
+
+        double offsetTime = timeIt([&]{
+            for (auto n : model->nodes){ model->activeNode = n; mesher.generateOffsetSurface(offset); }
+        }, 1);
+        int offsetFaces = countFaces(model);
+
+        std::cout << "  " << qPrintable(shape.name)
+                  << "  curves " << numCurves << "  sheets " << numSheets
+                  << "  regular " << regularTime << " ms"
+                  << "  offset " << offsetTime << " ms"
+                  << "  faces " << regularFaces << " / " << offsetFaces << std::endl;
+
+        record("mesher", QVariantMap{ {"shape", shape.name}, {"curves", numCurves}, {"sheets", numSheets} },
+               QVariantMap{ {"regular", regularTime}, {"offset", offsetTime},
+                            {"regularFaces", regularFaces}, {"offsetFaces", offsetFaces} });
+    }
+}
@@ -0,0 +1,123 @@
+#include "Benchmarks.h"
+#include "BVH.h"
+
+#include <QMap>
+#include <iostream>
+#include <random>
+
+using namespace Benchmarks;
+
+// Same test as GeometryHelper::intersectRayTri, used by the brute force path
+static bool intersectRayTri(const std::vector<Vector3> & tri, const Vector3 & rayOrigin,
+    const Vector3 & rayDirection, Vector3 & intersectionPoint)
+{
+    double u, v, t;
+    Vector3 edge1 = tri[1] - tri[0];
+    Vector3 edge2 = tri[2] - tri[0];
+    Vector3 pvec = rayDirection.cross(edge2);
+    double det = edge1.dot(pvec);
+    if (det == 0) return false;
+    double invDet = 1 / det;
+    Vector3 tvec = rayOrigin - tri[0];
+    u = tvec.dot(pvec) * invDet;
+    if (u < 0 || u > 1) return false;
+    Vector3 qvec = tvec.cross(edge1);
+    v = rayDirection.dot(qvec) * invDet;
+    if (v < 0 || u + v > 1) return false;
+    t = edge2.dot(qvec) * invDet;
+    intersectionPoint = rayOrigin + (t * rayDirection);
+    return true;
+}
+
+// Model::selectPart before the hierarchy
+static int pickBruteForce(const std::vector<Part> & parts, const Vector3 & origin, const Vector3 & direction)
+{
+    QMap< double, QPair<int, Vector3> > isects;
+    QMap< double, int > isectNode;
+    Vector3 ipoint;
+
+    for (int p = 0; p < int(parts.size()); p++){
+        for (int f = 0; f < int(parts[p].triangles.size()); f++){
+            std::vector<Vector3> tri;
+            for (int i = 0; i < 3; i++) tri.push_back(parts[p].points[parts[p].triangles[f][i]]);
+
+            if (intersectRayTri(tri, origin, direction, ipoint)){
+                double dist = (origin - ipoint).norm();
+                isects[dist] = qMakePair(f, ipoint);
+                isectNode[dist] = p;
+            }
+        }
+    }
+
+    return isects.size() ? isectNode[isects.keys().front()] : -1;
+}
+
+void Benchmarks::picking()
+{
+    std::cout << "picking" << std::endl;
+
+    int numParts = 8, numRays = 100;
+
+    for (int facesPerPart : { 2000, 20000, 100000 })
+    {
+        auto parts = makeSphereParts(numParts, facesPerPart);
+
+        int numFaces = 0;
+        for (auto & p : parts) numFaces += int(p.triangles.size());
+
+        // Rays from above the layout towards random points on it
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<double> uniform(-1, 8);
+        std::vector<Vector3> origins, directions;
+        for (int i = 0; i < numRays; i++){
+            Vector3 target(uniform(rng), uniform(rng), 0);
+            origins.push_back(Vector3(3, 3, 10));
+            directions.push_back(target - origins.back());
+        }
+
+        std::vector<int> expected(numRays), result(numRays);
+
+        double bruteTime = timeIt([&]{
+            for (int i = 0; i < numRays; i++) expected[i] = pickBruteForce(parts, origins[i], directions[i]);
+        }, 1);
+
+        // Hierarchies are built once and reused across clicks
+        std::vector<MeshBVH> partBVHs(parts.size());
+        BVH topBVH;
+        double buildTime = timeIt([&]{
+            std::vector<BVH::Box> boxes;
+            for (size_t p = 0; p < parts.size(); p++){
+                partBVHs[p].build(parts[p].points, parts[p].triangles);
+                boxes.push_back(partBVHs[p].bounds());
+            }
+            topBVH.build(boxes);
+        }, 1);
+
+        double bvhTime = timeIt([&]{
+            for (int i = 0; i < numRays; i++){
+                int hitPart = -1;
+                double tMax = std::numeric_limits<double>::max();
+                topBVH.raycast(origins[i], directions[i], tMax, [&](int p, double & tClosest){
+                    int triangle;
+                    if (!partBVHs[p].raycast(origins[i], directions[i], tClosest, triangle)) return false;
+                    hitPart = p;
+                    return true;
+                });
+                result[i] = hitPart;
+            }
+        });
+
+        int mismatches = 0;
+        for (int i = 0; i < numRays; i++) if (expected[i] != result[i]) mismatches++;
+
+        std::cout << "  faces " << numFaces
+                  << "  brute force " << bruteTime / numRays << " ms/pick"
+                  << "  bvh " << bvhTime / numRays << " ms/pick"
+                  << "  build " << buildTime << " ms"
+                  << "  mismatches " << mismatches << std::endl;
+
+        record("picking", QVariantMap{ {"faces", numFaces}, {"parts", numParts}, {"rays", numRays} },
+               QVariantMap{ {"bruteForcePerPick", bruteTime / numRays}, {"bvhPerPick", bvhTime / numRays},
+                            {"build", buildTime}, {"mismatches", mismatches} });
+    }
+}
@@ -0,0 +1,64 @@
+#include "Benchmarks.h"
+#include "Model.h"
+#include "Tools/StructureTransfer/IsotropicRemesher.h"
+
+#include <iostream>
+
+using namespace Benchmarks;
+
+// IsotropicRemesher::apply with the defaults StructureTransfer uses, on clones of the input
+static double remeshTime(const QVector<SurfaceMeshModel*> & meshes, int & numFaces)
+{
+    QVector< QSharedPointer<SurfaceMeshModel> > copies;
+    for (auto m : meshes) copies << QSharedPointer<SurfaceMeshModel>(m->clone());
+
+    double time = timeIt([&]{
+        for (auto m : copies){
+            Remesh::IsotropicRemesher mesher(m.data());
+            mesher.apply();
+        }
+    }, 1);
+
+    numFaces = 0;
+    for (auto m : copies) numFaces += m->n_faces();
+    return time;
+}
+
+void Benchmarks::remesh()
+{
+    std::cout << "remesh" << std::endl;
+
+    for (int facesPerPart : { 2000, 20000 })
+    {
+        auto mesh = QSharedPointer<SurfaceMeshModel>(makeMesh(makeTorusParts(1, facesPerPart), false));
+
+        int numFaces = 0;
+        double time = remeshTime(QVector<SurfaceMeshModel*>() << mesh.data(), numFaces);
+
+        std::cout << "  torus faces " << mesh->n_faces() << "  remesh " << time << " ms  faces " << numFaces << std::endl;
+
+        record("remesh", QVariantMap{ {"fixture", "torus"}, {"faces", int(mesh->n_faces())} },
+               QVariantMap{ {"remesh", time}, {"remeshedFaces", numFaces} });
+    }
+
+    // All parts of a shape, as the structure transfer tool remeshes them
+    for (auto shape : shapeSet())
+    {
+        QVector<SurfaceMeshModel*> meshes;
+        int inputFaces = 0;
+        for (auto n : shape.model->nodes){
+            auto m = shape.model->getMesh(n->id);
+            if (!m || m->n_faces() < 1) continue;
+            meshes << m;
+            inputFaces += m->n_faces();
+        }
+
+        int numFaces = 0;
+        double time = remeshTime(meshes, numFaces);
+
+        std::cout << "  " << qPrintable(shape.name) << " faces " << inputFaces << "  remesh " << time << " ms  faces " << numFaces << std::endl;
+
+        record("remesh", QVariantMap{ {"fixture", shape.name}, {"faces", inputFaces} },
+               QVariantMap{ {"remesh", time}, {"remeshedFaces", numFaces} });
+    }
+}
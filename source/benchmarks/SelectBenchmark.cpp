@@ -0,0 +1,91 @@
+#include "Benchmarks.h"
+#include "Model.h"
+
+#include <iostream>
+#include <random>
+
+using namespace Benchmarks;
+
+// Model::selectPart on whole shapes, the first click after an edit rebuilds the hierarchies
+void Benchmarks::select()
+{
+    std::cout << "select" << std::endl;
+
+    int numRays = 100;
+
+    for (auto shape : shapeSet())
+    {
+        auto model = shape.model.data();
+
+        int numFaces = 0;
+        for (auto n : model->nodes){
+            auto mesh = model->getMesh(n->id);
+            if (mesh) numFaces += mesh->n_faces();
+        }
+
+        // Rays from around the shape towards random points in its box
+        auto box = model->robustBBox();
+        Vector3 center = box.center();
+        double radius = box.diagonal().norm();
+
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<double> uniform(0, 1);
+        QVector<QVector3D> origins, directions;
+        for (int i = 0; i < numRays; i++){
+            Vector3 origin = center + radius * Vector3(uniform(rng) - 0.5, uniform(rng) - 0.5, uniform(rng) - 0.5).normalized();
+            Vector3 target = box.min() + Vector3(uniform(rng), uniform(rng), uniform(rng)).cwiseProduct(box.sizes());
+            Vector3 direction = target - origin;
+            origins << QVector3D(origin[0], origin[1], origin[2]);
+            directions << QVector3D(direction[0], direction[1], direction[2]);
+        }
+
+        double firstTime = timeIt([&]{
+            model->invalidateMeshes();
+            model->selectPart(origins.front(), directions.front());
+        });
+
+        int numSelected = 0;
+        double pickTime = timeIt([&]{
+            numSelected = 0;
+            for (int i = 0; i < numRays; i++){
+                model->selectPart(origins[i], directions[i]);
+                if (model->activeNode) numSelected++;
+            }
+        });
+
+        std::cout << "  " << qPrintable(shape.name)
+                  << "  faces " << numFaces
+                  << "  first " << firstTime << " ms"
+                  << "  pick " << pickTime / numRays << " ms"
+                  << "  hits " << numSelected << std::endl;
+
+        record("select", QVariantMap{ {"shape", shape.name}, {"faces", numFaces}, {"rays", numRays} },
+               QVariantMap{ {"first", firstTime}, {"perPick", pickTime / numRays}, {"hits", numSelected} });
+    }
+
+    // A thicker surface has the same connectivity as the thin one, the pick must still see it
+    {
+        QSharedPointer<Model> model(new Model);
+        QVector<QVector3D> points;
+        for (int i = 0; i <= 10; i++) points << QVector3D(0, 0, i * 0.1);
+        model->createCurveFromPoints(points);
+        auto part = model->activeNode;
+
+        QVector3D origin(0.1, -1, 0.5), direction(0, 1, 0);
+
+        model->generateSurface(0.025);
+        model->selectPart(origin, direction);
+        bool isThinHit = (model->activeNode == part);
+
+        model->activeNode = part;
+        model->generateSurface(0.2);
+        model->selectPart(origin, direction);
+        bool isThickHit = (model->activeNode == part);
+
+        bool isCurrent = !isThinHit && isThickHit;
+        std::cout << "  regenerated part " << (isCurrent ? "picked" : "STALE") << std::endl;
+
+        record("select", QVariantMap{ {"shape", "regenerated"} }, QVariantMap{ {"isCurrent", isCurrent} });
+        expect(isCurrent, "select: picking a regenerated part uses its new surface");
+    }
+}
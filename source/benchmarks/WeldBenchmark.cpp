@@ -0,0 +1,79 @@
+#include "Benchmarks.h"
+#include "VertexWelder.h"
+#include "SDFGen/marchingcubes.h"
+
+#include <iostream>
+#include <cstring>
+
+using namespace Benchmarks;
+
+// Marching cubes soup of a sphere, every triangle with its own three corners
+static std::vector<Vector3> sphereSoup(int gridSize)
+{
+    std::vector<float> grid(size_t(gridSize) * gridSize * gridSize);
+    double center = (gridSize - 1) * 0.5, radius = gridSize * 0.4;
+    for (int z = 0; z < gridSize; z++) for (int y = 0; y < gridSize; y++) for (int x = 0; x < gridSize; x++)
+        grid[x + gridSize * (y + gridSize * z)] = float(Vector3(x - center, y - center, z - center).norm() - radius);
+
+    auto mesh = marchIndexed(&grid[0], gridSize, gridSize, gridSize, 0.0);
+
+    std::vector<Vector3> soup;
+    soup.reserve(mesh.triangles.size());
+    for (int v : mesh.triangles){
+        auto & p = mesh.vertices[v];
+        soup.push_back(Vector3(p.x, p.y, p.z));
+    }
+    return soup;
+}
+
+// Exact matching on raw coordinates, as the welding before the hash grid did
+struct ExactHash{
+    size_t operator()(const Vector3 & p) const {
+        size_t h = 0;
+        for (int i = 0; i < 3; i++){
+            double c = p[i];
+            std::uint64_t bits;
+            std::memcpy(&bits, &c, sizeof(bits));
+            h ^= std::hash<std::uint64_t>()(bits) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        }
+        return h;
+    }
+};
+
+static std::vector<Vector3> weldExact(const std::vector<Vector3> & points, std::vector<int> & xrefs)
+{
+    std::unordered_map<Vector3, int, ExactHash> index;
+    std::vector<Vector3> welded;
+    xrefs.resize(points.size());
+    for (size_t i = 0; i < points.size(); i++){
+        auto found = index.insert(std::make_pair(points[i], int(welded.size())));
+        if (found.second) welded.push_back(points[i]);
+        xrefs[i] = found.first->second;
+    }
+    return welded;
+}
+
+void Benchmarks::weld()
+{
+    std::cout << "weld" << std::endl;
+
+    for (int gridSize : { 40, 128, 400 })
+    {
+        auto soup = sphereSoup(gridSize);
+
+        std::vector<int> exactRefs, hashRefs;
+        size_t exactCount = 0, hashCount = 0;
+
+        double exactTime = timeIt([&]{ exactCount = weldExact(soup, exactRefs).size(); });
+        double hashTime = timeIt([&]{ hashCount = weldPoints(soup, hashRefs, 1e-4).size(); });
+
+        std::cout << "  triangles " << soup.size() / 3
+                  << "  exact " << exactTime << " ms"
+                  << "  hash grid " << hashTime << " ms"
+                  << "  vertices " << exactCount << " / " << hashCount << std::endl;
+
+        record("weld", QVariantMap{ {"triangles", int(soup.size() / 3)} },
+               QVariantMap{ {"exact", exactTime}, {"hashGrid", hashTime},
+                            {"exactVertices", int(exactCount)}, {"hashGridVertices", int(hashCount)} });
+    }
+}
@@ -0,0 +1,123 @@
+# Benchmarks of the geometry code paths, run from the command line and reported as JSON
+QT          += core gui opengl widgets xml concurrent
+
+TARGET      = TopoBlenderBenchmarks
+TEMPLATE    = app
+CONFIG      += console
+CONFIG      -= app_bundle
+DESTDIR     = $$PWD/../../bin
+
+INCLUDEPATH += .. ../external
+
+# Commit the report is filed under, taken when qmake runs
+BENCHMARK_COMMIT = $$system(git -C $$PWD rev-parse --short HEAD)
+isEmpty(BENCHMARK_COMMIT): BENCHMARK_COMMIT = unknown
+DEFINES += BENCHMARK_COMMIT=\\\"$$BENCHMARK_COMMIT\\\"
+
+SOURCES +=  main.cpp \
+            Fixtures.cpp \
+            PickingBenchmark.cpp \
+            WeldBenchmark.cpp \
+            LevelSetBenchmark.cpp \
+            MergeBenchmark.cpp \
+            MesherBenchmark.cpp \
+            SelectBenchmark.cpp \
+            ConnectorBenchmark.cpp \
+            EmbedBenchmark.cpp \
+            RemeshBenchmark.cpp \
+# Code under test and what it pulls in
+            ../BVH.cpp \
+            ../Model.cpp \
+            ../ModelDraw.cpp \
+            ../ModelMesher.cpp \
+            ../ModelConnector.cpp \
+            ../Viewer.cpp \
+            ../GraphicsView.cpp \
+            ../Document.cpp \
+            ../DocumentGui.cpp \
+            ../DocumentAnalyzeWorker.cpp \
+            ../PairwiseCache.cpp \
+            ../ThumbnailCache.cpp \
+            ../CorrespondenceFile.cpp \
+            ../CorrespondenceIndex.cpp \
+            ../ModelCache.cpp \
+            ../BasicMesh.cpp \
+            ../Thumbnail.cpp \
+            ../OffscreenRenderer.cpp \
+            ../ResolveCorrespondence.cpp \
+            ../Tools/Explore/ExploreProcess.cpp \
+            ../Tools/Explore/Embedding.cpp
+
+HEADERS +=  Benchmarks.h \
+            ../BVH.h \
+            ../VertexWelder.h \
+            ../GeometryHelper.h \
+            ../Model.h \
+            ../ModelMesher.h \
+            ../ModelConnector.h \
+            ../Viewer.h \
+            ../GraphicsView.h \
+            ../Document.h \
+            ../DocumentAnalyzeWorker.h \
+            ../PairwiseCache.h \
+            ../ThumbnailCache.h \
+            ../CorrespondenceFile.h \
+            ../CorrespondenceIndex.h \
+            ../ModelCache.h \
+            ../BasicMesh.h \
+            ../Thumbnail.h \
+            ../OffscreenRenderer.h \
+            ../ResolveCorrespondence.h \
+            ../Tools/Explore/ExploreProcess.h \
+            ../Tools/Explore/Embedding.h \
+            ../Tools/StructureTransfer/IsotropicRemesher.h
+
+win32{
+    # Eigen 3.2.5 introduced some new warnings
+    QMAKE_CXXFLAGS *= /wd4522
+
+    LIBS += -lopengl32 -lglu32
+}
+
+linux-g++{ LIBS += -lGLU }
+
+# C++11 support on linux
+linux-g++{ CONFIG += c++11 warn_off }
+
+# OpenMP
+win32{
+    QMAKE_CXXFLAGS *= /openmp
+}
+unix:!mac{
+    QMAKE_CXXFLAGS *= -fopenmp
+    LIBS += -lgomp
+}
+
+### GeoTopo Libraries
+
+# Build flag
+CONFIG(debug, debug|release) {CFG = debug} else {CFG = release}
+
+# GeoTopo library
+LIBS += -L$$PWD/../../../GeoTopo/source/GeoTopoLib/lib/$$CFG -lGeoTopoLib
+INCLUDEPATH += ../../../GeoTopo/source/GeoTopoLib
+
+# StructureGraph library
+LIBS += -L$$PWD/../../../GeoTopo/source/StructureGraphLib/lib/$$CFG -lStructureGraphLib
+INCLUDEPATH += ../../../GeoTopo/source/StructureGraphLib
+
+# Surface Reconstruction library
+LIBS += -L$$PWD/../../../GeoTopo/source/Reconstruction/lib/$$CFG -lReconstruction
+INCLUDEPATH += ../../../GeoTopo/source/Reconstruction
+
+# Surface mesh library
+LIBS += -L$$PWD/../../../GeoTopo/source/external/SurfaceMesh/lib/$$CFG -lSurfaceMesh
+INCLUDEPATH += ../../../GeoTopo/source/external/SurfaceMesh ../../../GeoTopo/source/external/SurfaceMesh/surface_mesh
+
+# NURBS library
+LIBS += -L$$PWD/../../../GeoTopo/source/NURBS/lib/$$CFG -lNURBS
+INCLUDEPATH += ../../../GeoTopo/source/NURBS
+
+### Other libraries
+# SDF library
+INCLUDEPATH += ../external/SDFGen
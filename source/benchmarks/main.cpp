@@ -0,0 +1,94 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QStringList>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QThread>
+#include <QSaveFile>
+#include <functional>
+#include <iostream>
+
+#include "Benchmarks.h"
+
+// Commit the suite was built from, set by benchmarks.pro
+#ifndef BENCHMARK_COMMIT
+#define BENCHMARK_COMMIT "unknown"
+#endif
+
+static QJsonArray records;
+static QStringList failures;
+
+void Benchmarks::record(QString benchmark, QVariantMap parameters, QVariantMap results)
+{
+    QJsonObject entry;
+    entry["benchmark"] = benchmark;
+    entry["parameters"] = QJsonObject::fromVariantMap(parameters);
+    entry["results"] = QJsonObject::fromVariantMap(results);
+    records.append(entry);
+}
+
+void Benchmarks::expect(bool condition, QString what)
+{
+    if (condition) return;
+    std::cerr << "FAILED " << qPrintable(what) << std::endl;
+    failures << what;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QList< QPair<QString, std::function<void()> > > benchmarks;
+    benchmarks << qMakePair(QString("picking"), std::function<void()>(Benchmarks::picking))
+               << qMakePair(QString("weld"), std::function<void()>(Benchmarks::weld))
+               << qMakePair(QString("levelset"), std::function<void()>(Benchmarks::levelset))
+               << qMakePair(QString("merge"), std::function<void()>(Benchmarks::merge))
+               << qMakePair(QString("mesher"), std::function<void()>(Benchmarks::mesher))
+               << qMakePair(QString("select"), std::function<void()>(Benchmarks::select))
+               << qMakePair(QString("connector"), std::function<void()>(Benchmarks::connector))
+               << qMakePair(QString("embed"), std::function<void()>(Benchmarks::embed))
+               << qMakePair(QString("remesh"), std::function<void()>(Benchmarks::remesh));
+
+    QStringList names;
+    for (auto & b : benchmarks) names << b.first;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Timings of the geometry code paths, written as JSON for comparison across commits");
+    parser.addHelpOption();
+    parser.addPositionalArgument("benchmarks", "Any of " + names.join(", ") + ". All when omitted.");
+
+    QCommandLineOption jsonOption("json", "Report file, benchmarks_<commit>.json by default.", "file",
+                                  QString("benchmarks_%1.json").arg(BENCHMARK_COMMIT));
+    QCommandLineOption datasetOption("dataset", "Also run the shape benchmarks on the shapes of this dataset.", "folder");
+    parser.addOptions(QList<QCommandLineOption>() << jsonOption << datasetOption);
+    parser.process(a);
+
+    QStringList selected = parser.positionalArguments();
+    auto isSelected = [&](QString name){ return selected.isEmpty() || selected.contains(name); };
+
+    if (parser.isSet(datasetOption)) Benchmarks::setDatasetFolder(parser.value(datasetOption));
+
+    for (auto & b : benchmarks)
+        if (isSelected(b.first)) b.second();
+
+    QJsonObject report;
+    report["commit"] = QString(BENCHMARK_COMMIT);
+    report["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["host"] = QSysInfo::machineHostName();
+    report["cpu"] = QSysInfo::currentCpuArchitecture();
+    report["threads"] = QThread::idealThreadCount();
+    report["records"] = records;
+    report["failures"] = QJsonArray::fromStringList(failures);
+
+    QSaveFile file(parser.value(jsonOption));
+    if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(report).toJson()) < 0 || !file.commit()){
+        std::cerr << "Could not write " << qPrintable(parser.value(jsonOption)) << std::endl;
+        return 1;
+    }
+
+    std::cout << "report " << qPrintable(parser.value(jsonOption)) << std::endl;
+    return failures.isEmpty() ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QEventLoop>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QFile>
+#include <QDir>
+#include <QTextStream>
+#include <iostream>
+
+#include "Document.h"
+#include "DocumentAnalyzeWorker.h"
+#include "Tools/AutoBlend/BlendJob.h"
+
+// Triangle soups of the parts as OBJ groups, point parts are written as vertices only
+static bool writeObj(QString filename, const QVector<QBasicMesh> & parts)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+
+    QTextStream out(&file);
+    int offset = 1;
+
+    for (int p = 0; p < parts.size(); p++)
+    {
+        auto & part = parts[p];
+        out << "g part" << p << "\n";
+
+        for (auto v : part.points) out << "v " << v.x() << " " << v.y() << " " << v.z() << "\n";
+        for (auto n : part.normals) out << "vn " << n.x() << " " << n.y() << " " << n.z() << "\n";
+
+        bool hasNormals = part.normals.size() == part.points.size();
+        if (!part.isPoints)
+        {
+            for (int i = 0; i + 2 < part.points.size(); i += 3)
+            {
+                out << "f";
+                for (int c = 0; c < 3; c++){
+                    int idx = offset + i + c;
+                    out << " " << idx;
+                    if (hasNormals) out << "//" << idx;
+                }
+                out << "\n";
+            }
+        }
+
+        offset += part.points.size();
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    // Same settings as the GUI
+    QCoreApplication::setOrganizationName("TopoBlender");
+    QCoreApplication::setOrganizationDomain("github.com/ialhashim/TopoBlender");
+    QCoreApplication::setApplicationName("TopoBlender");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Dataset analysis and blending without a window or GL context");
+    parser.addHelpOption();
+    parser.addPositionalArgument("dataset", "Dataset folder");
+
+    QCommandLineOption categoryOption("category", "Category to process, all categories when omitted.", "name");
+    QCommandLineOption pairwiseOption("pairwise", "Match all pairs of shapes of the category.");
+    QCommandLineOption analyzeOption("analyze", "Compute part correspondence with respect to a source shape.");
+    QCommandLineOption sourceOption("source", "Source shape of the analysis, the first shape of the category by default.", "name");
+    QCommandLineOption blendOption("blend", "Blend all pairs of the category, or only 'source,target'.", "pairs", "all");
+    QCommandLineOption countOption("count", "Number of in-between shapes per pair.", "n", "2");
+    QCommandLineOption lodOption("lod", "Level of detail of blends, 0 to 2.", "level", "0");
+    QCommandLineOption outputOption("output", "Folder of the OBJ exports.", "folder", "blends");
+    QCommandLineOption shardOption("shard", "Match and blend only pairs k, k + n, k + 2n, ... to split the work across machines.", "k/n", "0/1");
+
+    parser.addOptions(QList<QCommandLineOption>() << categoryOption << pairwiseOption << analyzeOption << sourceOption
+                      << blendOption << countOption << lodOption << outputOption << shardOption);
+    parser.process(a);
+
+    if (parser.positionalArguments().isEmpty()) parser.showHelp(1);
+
+    // In-between shapes are spread from one end of the blend to the other, which takes two at least
+    bool isCount = false;
+    int count = parser.value(countOption).toInt(&isCount);
+    if (!isCount || count < 2){
+        std::cerr << "--count must be a number of at least 2\n";
+        parser.showHelp(1);
+    }
+
+    bool isLod = false;
+    int lod = parser.value(lodOption).toInt(&isLod);
+    if (!isLod || lod < 0 || lod > 2){
+        std::cerr << "--lod must be 0, 1 or 2\n";
+        parser.showHelp(1);
+    }
+
+    // Shard k of n, with 0 <= k < n
+    auto shard = parser.value(shardOption).split("/");
+    bool isShardIndex = false, isShardCount = false;
+    int shardIndex = shard.front().toInt(&isShardIndex), shardCount = shard.back().toInt(&isShardCount);
+    if (shard.size() != 2 || !isShardIndex || !isShardCount || shardIndex < 0 || shardIndex >= shardCount){
+        std::cerr << "--shard must be k/n with 0 <= k < n\n";
+        parser.showHelp(1);
+    }
+
+    Document document;
+    if (!document.loadDataset(parser.positionalArguments().front())){
+        std::cerr << "Could not load dataset\n";
+        return 1;
+    }
+
+    QStringList categories = parser.isSet(categoryOption) ? QStringList(parser.value(categoryOption)) : document.categories.keys();
+
+    int exitCode = 0;
+
+    for (auto category : categories)
+    {
+        if (!document.categories.contains(category)){
+            std::cerr << "Unknown category " << qPrintable(category) << "\n";
+            exitCode = 1;
+            continue;
+        }
+
+        document.currentCategory = category;
+        auto catModels = document.categories[category].toStringList();
+        if (catModels.isEmpty()) continue;
+        std::cout << qPrintable(category) << ": " << catModels.size() << " shapes\n";
+
+        DocumentAnalyzeWorker worker(&document);
+        worker.shardIndex = shardIndex;
+        worker.shardCount = shardCount;
+        QObject::connect(&worker, &DocumentAnalyzeWorker::progressText, [](QString text){ std::cout << "  " << qPrintable(text) << "\n"; });
+
+        if (parser.isSet(pairwiseOption)) worker.processAllPairWise();
+
+        if (parser.isSet(analyzeOption) || parser.isSet(blendOption))
+        {
+            // The analysis runs against the shape loaded first, as in the GUI
+            QString sourceName = parser.isSet(sourceOption) ? parser.value(sourceOption) : catModels.front();
+            if (!catModels.contains(sourceName) || !document.dataset.contains(sourceName)){
+                std::cerr << "--source " << qPrintable(sourceName) << " is not a shape of " << qPrintable(category) << "\n";
+                parser.showHelp(1);
+            }
+
+            document.clearModels();
+            if (!document.loadModel(document.dataset[sourceName]["graphFile"].toString())){
+                std::cerr << "Could not load source shape " << qPrintable(sourceName) << "\n";
+                return 1;
+            }
+
+            worker.processShapeDataset();
+            document.indexCorrespondence();
+        }
+
+        if (!parser.isSet(blendOption)) continue;
+
+        // Pairs to blend, every machine of a shard takes its own share
+        QVector< QPair<QString,QString> > pairs;
+        auto blendPairs = parser.value(blendOption);
+        if (blendPairs == "all")
+        {
+            for (int i = 0; i < catModels.size(); i++)
+                for (int j = i + 1; j < catModels.size(); j++)
+                    pairs << qMakePair(catModels[i], catModels[j]);
+        }
+        else
+        {
+            auto names = blendPairs.split(",");
+            if (names.size() == 2) pairs << qMakePair(names.front(), names.back());
+        }
+
+        QString outputFolder = parser.value(outputOption);
+        QDir().mkpath(outputFolder);
+
+        QThreadPool pool;
+        QEventLoop loop;
+        int numRunning = 0;
+        QVector< QSharedPointer<BlendJob> > jobs;
+
+        for (int p = 0; p < pairs.size(); p++)
+        {
+            if (p % shardCount != shardIndex) continue;
+
+            auto job = QSharedPointer<BlendJob>(new BlendJob(&document, pairs[p].first, pairs[p].second,
+                                                             count, lod));
+
+            auto numWritten = QSharedPointer<int>(new int(0));
+            QObject::connect(job.data(), &BlendJob::resultReady, [=, &exitCode](QString name, QVector<QBasicMesh> parts){
+                QString filename = QString("%1/%2_%3.obj").arg(outputFolder).arg(name).arg((*numWritten)++);
+                bool isWritten = writeObj(filename, parts);
+                std::cout << "  " << qPrintable(filename) << (isWritten ? "" : " could not be written") << "\n";
+                if (!isWritten) exitCode = 1;
+            });
+            QObject::connect(job.data(), &BlendJob::finished, [&](){ if (--numRunning == 0) loop.quit(); });
+
+            jobs << job;
+            numRunning++;
+            QtConcurrent::run(&pool, [job](){ job->run(); });
+        }
+
+        // Results are handed over through the event loop
+        if (numRunning > 0) loop.exec();
+    }
+
+    return exitCode;
+}
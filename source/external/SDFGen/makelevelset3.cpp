@@ -190,3 +190,172 @@ void make_level_set3(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x
 		}
 	}
 }
+
+// sweep that skips inactive bricks of brick^3 cells
+static void sweep_band(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x,
+	Array3f &phi, Array3i &closest_tri, const Vec3f &origin, float dx,
+	int di, int dj, int dk, float limit_distance,
+	const std::vector<char> &active, int brick, int bricks_i, int bricks_j)
+{
+	int i0, i1;
+	if (di > 0){ i0 = 1; i1 = phi.ni; }
+	else{ i0 = phi.ni - 2; i1 = -1; }
+	int j0, j1;
+	if (dj > 0){ j0 = 1; j1 = phi.nj; }
+	else{ j0 = phi.nj - 2; j1 = -1; }
+	int k0, k1;
+	if (dk > 0){ k0 = 1; k1 = phi.nk; }
+	else{ k0 = phi.nk - 2; k1 = -1; }
+
+	for (int k = k0; k != k1; k += dk) for (int j = j0; j != j1; j += dj){
+		const char * row = &active[bricks_i * ((j / brick) + bricks_j * (k / brick))];
+
+		for (int i = i0; (i1 - i) * di > 0; i += di){
+			if (!row[i / brick]){
+				// jump to the last cell of this brick in the sweep direction
+				i = (di > 0) ? (i / brick) * brick + brick - 1 : (i / brick) * brick;
+				continue;
+			}
+
+			Vec3f gx(i*dx + origin[0], j*dx + origin[1], k*dx + origin[2]);
+
+			if (phi(i,j,k) > limit_distance) continue;
+
+			check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i - di, j, k);
+			check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i, j - dj, k);
+			check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i - di, j - dj, k);
+			check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i, j, k - dk);
+			check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i - di, j, k - dk);
+			check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i, j - dj, k - dk);
+			check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i - di, j - dj, k - dk);
+		}
+	}
+}
+
+void make_level_set3_parallel(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x,
+	const Vec3f &origin, float dx, int ni, int nj, int nk,
+	Array3f &phi, bool isSigned, float limit_distance, const int exact_band)
+{
+	phi.resize(ni, nj, nk);
+	phi.assign(limit_distance); // upper bound on distance
+	Array3i closest_tri(ni, nj, nk, -1);
+	Array3i intersection_count(ni, nj, nk, 0);
+
+	// coordinates in grid to high precision, and the cells near each triangle
+	std::vector<double> fx(tri.size() * 9);
+	std::vector<Vec3i> band_min(tri.size()), band_max(tri.size());
+	for (unsigned int t = 0; t < tri.size(); ++t){
+		unsigned int p, q, r; assign(tri[t], p, q, r);
+		unsigned int v[3] = { p, q, r };
+		double * f = &fx[t * 9];
+		for (int c = 0; c < 3; ++c) for (int axis = 0; axis < 3; ++axis)
+			f[c * 3 + axis] = ((double)x[v[c]][axis] - origin[axis]) / dx;
+		int n[3] = { ni, nj, nk };
+		for (int axis = 0; axis < 3; ++axis){
+			band_min[t][axis] = clamp(int(min(f[axis], f[3 + axis], f[6 + axis])) - exact_band, 0, n[axis] - 1);
+			band_max[t][axis] = clamp(int(max(f[axis], f[3 + axis], f[6 + axis])) + exact_band + 1, 0, n[axis] - 1);
+		}
+	}
+
+	// bin triangles into (j,k) tiles spanning all of i, each tile only writes its own cells
+	const int tile = 8;
+	int tiles_j = (nj + tile - 1) / tile, tiles_k = (nk + tile - 1) / tile;
+	std::vector< std::vector<unsigned int> > tiles(tiles_j * tiles_k);
+	for (unsigned int t = 0; t < tri.size(); ++t)
+		for (int tk = band_min[t][2] / tile; tk <= band_max[t][2] / tile; ++tk)
+			for (int tj = band_min[t][1] / tile; tj <= band_max[t][1] / tile; ++tj)
+				tiles[tj + tiles_j * tk].push_back(t);
+
+	// triangles are visited in the same order as make_level_set3, so ties resolve the same way
+	#pragma omp parallel for schedule(dynamic, 1)
+	for (int ti = 0; ti < int(tiles.size()); ++ti){
+		int tile_j0 = (ti % tiles_j) * tile, tile_j1 = std::min(tile_j0 + tile, nj) - 1;
+		int tile_k0 = (ti / tiles_j) * tile, tile_k1 = std::min(tile_k0 + tile, nk) - 1;
+
+		for (unsigned int t : tiles[ti]){
+			unsigned int p, q, r; assign(tri[t], p, q, r);
+			const double * f = &fx[t * 9];
+			double fip = f[0], fjp = f[1], fkp = f[2];
+			double fiq = f[3], fjq = f[4], fkq = f[5];
+			double fir = f[6], fjr = f[7], fkr = f[8];
+
+			// do distances nearby
+			int i0 = band_min[t][0], i1 = band_max[t][0];
+			int j0 = std::max(band_min[t][1], tile_j0), j1 = std::min(band_max[t][1], tile_j1);
+			int k0 = std::max(band_min[t][2], tile_k0), k1 = std::min(band_max[t][2], tile_k1);
+			for (int k = k0; k <= k1; ++k) for (int j = j0; j <= j1; ++j) for (int i = i0; i <= i1; ++i){
+				Vec3f gx(i*dx + origin[0], j*dx + origin[1], k*dx + origin[2]);
+				float d = point_triangle_distance(gx, x[p], x[q], x[r]);
+				if (d < phi(i, j, k)){
+					phi(i, j, k) = d;
+					closest_tri(i, j, k) = t;
+				}
+			}
+
+			if (!isSigned) continue;
+
+			// and do intersection counts
+			j0 = std::max(clamp((int)std::ceil(min(fjp, fjq, fjr)), 0, nj - 1), tile_j0);
+			j1 = std::min(clamp((int)std::floor(max(fjp, fjq, fjr)), 0, nj - 1), tile_j1);
+			k0 = std::max(clamp((int)std::ceil(min(fkp, fkq, fkr)), 0, nk - 1), tile_k0);
+			k1 = std::min(clamp((int)std::floor(max(fkp, fkq, fkr)), 0, nk - 1), tile_k1);
+			for (int k = k0; k <= k1; ++k) for (int j = j0; j <= j1; ++j){
+				double a, b, c;
+				if (point_in_triangle_2d(j, k, fjp, fkp, fjq, fkq, fjr, fkr, a, b, c)){
+					double fi = a*fip + b*fiq + c*fir; // intersection i coordinate
+					int i_interval = int(std::ceil(fi)); // intersection is in (i_interval-1,i_interval]
+					if (i_interval < 0) ++intersection_count(0, j, k);
+					else if (i_interval < ni) ++intersection_count(i_interval, j, k);
+				}
+			}
+		}
+	}
+
+	// cells farther than limit_distance from every triangle never get a closest triangle,
+	// so only bricks near some triangle are swept
+	const int brick = 8;
+	int bricks_i = (ni + brick - 1) / brick, bricks_j = (nj + brick - 1) / brick, bricks_k = (nk + brick - 1) / brick;
+	std::vector<char> active(bricks_i * bricks_j * bricks_k, 1);
+
+	if (limit_distance < std::numeric_limits<float>::max() && !tri.empty()){
+		int band = std::max(int(std::ceil(limit_distance / dx)) + 1, exact_band + 1);
+
+		active.assign(active.size(), 0);
+		for (unsigned int t = 0; t < tri.size(); ++t){
+			const double * f = &fx[t * 9];
+			int n[3] = { ni, nj, nk }, lo[3], hi[3];
+			for (int axis = 0; axis < 3; ++axis){
+				lo[axis] = clamp(int(min(f[axis], f[3 + axis], f[6 + axis])) - band, 0, n[axis] - 1) / brick;
+				hi[axis] = clamp(int(max(f[axis], f[3 + axis], f[6 + axis])) + band + 1, 0, n[axis] - 1) / brick;
+			}
+			for (int bk = lo[2]; bk <= hi[2]; ++bk) for (int bj = lo[1]; bj <= hi[1]; ++bj) for (int bi = lo[0]; bi <= hi[0]; ++bi)
+				active[bi + bricks_i * (bj + bricks_j * bk)] = 1;
+		}
+	}
+
+	// and now we fill in the rest of the distances with fast sweeping
+	for (unsigned int pass = 0; pass < 2; ++pass){
+		sweep_band(tri, x, phi, closest_tri, origin, dx, +1, +1, +1, limit_distance, active, brick, bricks_i, bricks_j);
+		sweep_band(tri, x, phi, closest_tri, origin, dx, -1, -1, -1, limit_distance, active, brick, bricks_i, bricks_j);
+		sweep_band(tri, x, phi, closest_tri, origin, dx, +1, +1, -1, limit_distance, active, brick, bricks_i, bricks_j);
+		sweep_band(tri, x, phi, closest_tri, origin, dx, -1, -1, +1, limit_distance, active, brick, bricks_i, bricks_j);
+		sweep_band(tri, x, phi, closest_tri, origin, dx, +1, -1, +1, limit_distance, active, brick, bricks_i, bricks_j);
+		sweep_band(tri, x, phi, closest_tri, origin, dx, -1, +1, -1, limit_distance, active, brick, bricks_i, bricks_j);
+		sweep_band(tri, x, phi, closest_tri, origin, dx, +1, -1, -1, limit_distance, active, brick, bricks_i, bricks_j);
+		sweep_band(tri, x, phi, closest_tri, origin, dx, -1, +1, +1, limit_distance, active, brick, bricks_i, bricks_j);
+	}
+
+	if (!isSigned) return;
+
+	// then figure out signs (inside/outside) from intersection counts, rows are independent
+	#pragma omp parallel for
+	for (int k = 0; k < nk; ++k) for (int j = 0; j < nj; ++j){
+		int total_count = 0;
+		for (int i = 0; i < ni; ++i){
+			total_count += intersection_count(i, j, k);
+			if (total_count % 2 == 1){ // if parity of intersections so far is odd,
+				phi(i, j, k) = -phi(i, j, k); // we are inside the mesh
+			}
+		}
+	}
+}
@@ -14,6 +14,12 @@ void make_level_set3(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x
                      const Vec3f &origin, float dx, int nx, int ny, int nz,
 					 Array3f &phi, bool isSigned = true, float limit_distance = std::numeric_limits<float>::max(), const int exact_band = 1);
 
+// Same result as make_level_set3, multi-threaded. The exact band is computed over (j,k) tiles of the grid
+// that each own their cells, and the sweeps skip bricks that are farther than limit_distance from every triangle.
+void make_level_set3_parallel(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x,
+                     const Vec3f &origin, float dx, int nx, int ny, int nz,
+					 Array3f &phi, bool isSigned = true, float limit_distance = std::numeric_limits<float>::max(), const int exact_band = 1);
+
 #ifdef SDFGEN_HEADER_ONLY
 #include "makelevelset3.cpp"
 #endif
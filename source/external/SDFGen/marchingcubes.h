@@ -40,13 +40,13 @@ inline ScalarVolume addPaddingToVolume( const ScalarVolume & fromVolume, float v
 	return volume;
 }
 
-int mc_edtable[] = {
+static int mc_edtable[] = {
         0, 1, 1, 3, 3, 2, 2, 0,
         4, 5, 5, 7, 7, 6, 6, 4,
         0, 4, 1, 5, 2, 6, 3, 7
 };
 
-int mc_colidx[] = {
+static int mc_colidx[] = {
         0, 0, 3, 6, 12, 15, 21, 33, 42, 45,
         57, 63, 72, 78, 87, 96, 102, 105, 111, 123,
         132, 144, 153, 168, 180, 198, 213, 228, 240, 255,
@@ -74,7 +74,7 @@ int mc_colidx[] = {
         2418, 2424, 2433, 2442, 2448, 2457, 2463, 2469, 2472, 2481,
         2487, 2493, 2496, 2502, 2505, 2508, 2508
 };
-int mc_idxtable[] = {
+static int mc_idxtable[] = {
         /*0(00000000)*/
         /*1(10000000)*/ 0, 3, 8,
         /*2(01000000)*/ 1, 0, 9,
@@ -339,7 +339,7 @@ struct Point3f {
 	float z;
 };
 
-int polygonize( std::vector< std::pair<Point3f, double> >& cell, const double isovalue, std::vector<Point3f>& pnts, const double iso_eps = 1.0e-6) {
+inline int polygonize( std::vector< std::pair<Point3f, double> >& cell, const double isovalue, std::vector<Point3f>& pnts, const double iso_eps = 1.0e-6) {
 	unsigned char tableid = 0x00;
     for( int i = 0 ; i < 8 ; ++i ) {
 		if ( std::fabs( cell[i].second - isovalue ) < iso_eps ) cell[i].second = isovalue + iso_eps;
@@ -437,3 +437,134 @@ inline std::vector< std::vector<Point3f> > march( const ScalarVolume & volume, d
 
 	return allTriangles;
 }
+
+// Indexed marching cubes on a contiguous grid, value(x,y,z) = data[x + sx * (y + sy * z)].
+// One vertex is made per crossed grid edge and shared by the cells around it, so no welding is needed.
+// Slices are processed in parallel and merged in slice order, the output does not depend on the thread count.
+struct MCIndexedMesh {
+	std::vector<Point3f> vertices;
+	std::vector<int> triangles;
+};
+
+inline MCIndexedMesh marchIndexed( const float * data, int sx, int sy, int sz, double isovalue = 0.0, const double iso_eps = 1.0e-6 )
+{
+	MCIndexedMesh result;
+	if( sx < 2 || sy < 2 || sz < 2 ) return result;
+
+	const size_t slice = size_t(sx) * sy;
+	const size_t count = slice * sz;
+
+	// Same rule as polygonize, values on the isovalue count as inside
+	auto value = [&]( size_t i ) {
+		double v = data[i];
+		if ( std::fabs( v - isovalue ) < iso_eps ) v = isovalue + iso_eps;
+		return v;
+	};
+
+	// Cube edges as (corner offset, axis), corners are numbered dx + 2 dy + 4 dz
+	int edgeOffset[12][4];
+	for( int e = 0 ; e < 12 ; e++ ) {
+		int c0 = mc_edtable[2 * e], c1 = mc_edtable[2 * e + 1];
+		int base = std::min( c0, c1 ), bit = c0 ^ c1;
+		edgeOffset[e][0] = base & 1;
+		edgeOffset[e][1] = (base >> 1) & 1;
+		edgeOffset[e][2] = (base >> 2) & 1;
+		edgeOffset[e][3] = bit == 1 ? 0 : (bit == 2 ? 1 : 2);
+	}
+
+	// Grid edge -> vertex index, three edges per grid point
+	std::vector<int> edgeVertex( count * 3, -1 );
+
+	auto crosses = [&]( size_t a, size_t b ) {
+		return ( isovalue <= value(a) ) != ( isovalue <= value(b) );
+	};
+	const size_t step[3] = { 1, size_t(sx), slice };
+
+	// Count crossed edges starting in each slice
+	std::vector<int> sliceVertices( sz + 1, 0 );
+
+	#pragma omp parallel for
+	for( int z = 0 ; z < sz ; ++z ) {
+		int n = 0;
+		for( int y = 0 ; y < sy ; ++y ) {
+			for( int x = 0 ; x < sx ; ++x ) {
+				size_t i = x + sx * (y + size_t(sy) * z);
+				if( x + 1 < sx && crosses( i, i + step[0] ) ) n++;
+				if( y + 1 < sy && crosses( i, i + step[1] ) ) n++;
+				if( z + 1 < sz && crosses( i, i + step[2] ) ) n++;
+			}
+		}
+		sliceVertices[z + 1] = n;
+	}
+	for( int z = 0 ; z < sz ; ++z ) sliceVertices[z + 1] += sliceVertices[z];
+
+	// Place vertices
+	result.vertices.resize( sliceVertices[sz] );
+
+	#pragma omp parallel for
+	for( int z = 0 ; z < sz ; ++z ) {
+		int vi = sliceVertices[z];
+		for( int y = 0 ; y < sy ; ++y ) {
+			for( int x = 0 ; x < sx ; ++x ) {
+				size_t i = x + sx * (y + size_t(sy) * z);
+				int coord[3] = { x, y, z }, size[3] = { sx, sy, sz };
+				for( int axis = 0 ; axis < 3 ; axis++ ) {
+					if( coord[axis] + 1 >= size[axis] ) continue;
+					size_t j = i + step[axis];
+					if( !crosses( i, j ) ) continue;
+
+					double v0 = value(i), v1 = value(j);
+					double t = std::fabs( v0 - v1 ) < 1.0e-10 ? 0.5 : ( isovalue - v0 ) / ( v1 - v0 );
+
+					Point3f & p = result.vertices[vi];
+					p.x = float( x + (axis == 0 ? t : 0) );
+					p.y = float( y + (axis == 1 ? t : 0) );
+					p.z = float( z + (axis == 2 ? t : 0) );
+
+					edgeVertex[i * 3 + axis] = vi++;
+				}
+			}
+		}
+	}
+
+	// Triangles per slice of cells, appended in slice order
+	std::vector< std::vector<int> > sliceTriangles( sz - 1 );
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for( int z = 0 ; z < sz - 1 ; ++z ) {
+		auto & triangles = sliceTriangles[z];
+		for( int y = 0 ; y < sy - 1 ; ++y ) {
+			for( int x = 0 ; x < sx - 1 ; ++x ) {
+				size_t base = x + sx * (y + size_t(sy) * z);
+
+				unsigned char tableid = 0x00;
+				for( int c = 0 ; c < 8 ; ++c ) {
+					size_t i = base + (c & 1) * step[0] + ((c >> 1) & 1) * step[1] + ((c >> 2) & 1) * step[2];
+					if ( isovalue <= value(i) ) tableid |= ( 0x01 << c );
+				}
+				if ( tableid == 0x00 || tableid == 0xFF ) continue;
+
+				for( int k = mc_colidx[tableid] ; k < mc_colidx[tableid + 1] ; k += 3 ) {
+					int tri[3];
+					for( int c = 0 ; c < 3 ; c++ ) {
+						const int * e = edgeOffset[ mc_idxtable[k + c] ];
+						size_t i = base + e[0] * step[0] + e[1] * step[1] + e[2] * step[2];
+						tri[c] = edgeVertex[i * 3 + e[3]];
+					}
+
+					// Reversed winding, as in march()
+					triangles.push_back( tri[2] );
+					triangles.push_back( tri[1] );
+					triangles.push_back( tri[0] );
+				}
+			}
+		}
+	}
+
+	size_t numIndices = 0;
+	for( auto & t : sliceTriangles ) numIndices += t.size();
+	result.triangles.reserve( numIndices );
+	for( auto & t : sliceTriangles ) result.triangles.insert( result.triangles.end(), t.begin(), t.end() );
+
+	return result;
+}
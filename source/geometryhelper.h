@@ -2,7 +2,7 @@
 
 #include <QVector3D>
 #include <QStack>
-#include "weld.h"
+#include "VertexWelder.h"
 
 template<class Vector3> QVector3D toQVector3D(Vector3 p){ return QVector3D(p[0], p[1], p[2]); }
 
@@ -205,25 +205,55 @@ static inline QVector3D pointAt(QVector<QVector3D> points, double arc_length_par
 }
 
 template<class Vector3, class Mesh>
-inline void meregeVertices(Mesh * m){
+inline void meregeVertices(Mesh * m, double tolerance = 0){
 	std::vector<Vector3> vertices;
 	auto points = m->vertex_coordinates();
+	vertices.reserve(m->n_vertices());
 	for (auto v : m->vertices()) vertices.push_back(points[v]);
 
-	std::vector<size_t> xrefs;
-	weld(vertices, xrefs, std::hash_Vector3<Vector3>(), [&](const Vector3& a, const Vector3& b){ return a.isApprox(b); });
+	std::vector<int> xrefs;
+	auto welded = weldPoints(vertices, xrefs, tolerance);
+	if (welded.size() == vertices.size()) return;
 
-	std::vector< std::vector<typename Mesh::Vertex> > faces;
+	// Faces as one flat index list, the halfedge structure has to be rebuilt for the new vertices
+	std::vector<int> faceIndices, faceSizes;
+	faceIndices.reserve(m->n_faces() * 3);
+	faceSizes.reserve(m->n_faces());
 	for (auto f : m->faces()){
-		std::vector<typename Mesh::Vertex> face;
-		for (auto v : m->vertices(f)) face.push_back(typename Mesh::Vertex(xrefs[v.idx()]));
-		faces.push_back(face);
+		int size = 0;
+		for (auto v : m->vertices(f)){ faceIndices.push_back(xrefs[v.idx()]); size++; }
+		faceSizes.push_back(size);
 	}
 
 	m->clear();
 
-	for (auto v : vertices) m->add_vertex(v);
-	for (auto face : faces) m->add_face(face);
+	for (auto & v : welded) m->add_vertex(v);
+
+	std::vector<typename Mesh::Vertex> face;
+	size_t start = 0;
+	for (int size : faceSizes){
+		face.clear();
+		for (int i = 0; i < size; i++) face.push_back(typename Mesh::Vertex(faceIndices[start + i]));
+		start += size;
+		m->add_face(face);
+	}
+}
+
+// Adds a triangle soup to 'm', corners closer than 'tolerance' share a vertex and collapsed triangles are dropped
+template<class Vector3, class Mesh>
+inline void addWeldedTriangles(Mesh * m, const std::vector<Vector3> & soup, double tolerance = 0){
+	std::vector<int> xrefs;
+	auto welded = weldPoints(soup, xrefs, tolerance);
+
+	int offset = m->n_vertices();
+	for (auto & v : welded) m->add_vertex(v);
+
+	typedef typename Mesh::Vertex Vert;
+	for (size_t i = 0; i + 2 < soup.size(); i += 3){
+		int a = xrefs[i], b = xrefs[i + 1], c = xrefs[i + 2];
+		if (a == b || b == c || a == c) continue;
+		m->add_triangle(Vert(offset + a), Vert(offset + b), Vert(offset + c));
+	}
 }
 
 template<class Vector3>